@@ -0,0 +1,122 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file adaptive_sweep.hpp
+ * @brief Adaptive refinement of a parameter sweep over an integer grid.
+ */
+
+#ifndef FCPP_ADAPTIVE_SWEEP_H_
+#define FCPP_ADAPTIVE_SWEEP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include "lib/seed_stats.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Adaptive sweep over the grid points `0..n-1`.
+ *
+ * The sweep starts from a coarse grid, and at every refinement step measures the curves in the points
+ * evaluated so far. Midpoints are added to the intervals next to a point where some curve bends
+ * (deviates from the linear interpolation of its neighbours by more than a tolerance), and further seeds
+ * are requested for points whose confidence interval is wider than the tolerance. The tolerance of a
+ * curve is relative to the larger of its range and its scale (the magnitude of the values it may take),
+ * so that noise on a flat curve does not trigger refinements. Refinement stops when no interval or
+ * point needs further runs.
+ */
+class adaptive_sweep {
+  public:
+    //! @brief constructor given the grid size, the coarse step, the scale of each curve and the tolerance
+    adaptive_sweep(int n, int step, std::vector<double> scales, double tolerance = 0.05, int max_seeds = 4) : m_scales(scales), m_tolerance(tolerance), m_max_seeds(max_seeds) {
+        for (int i=0; i<n; i+=step) m_todo.push_back(i);
+        if (m_todo.back() != n-1) m_todo.push_back(n-1);
+    }
+
+    //! @brief the points to be evaluated in the next step (with the seed batch index for each)
+    std::vector<std::pair<int,int>> next() const {
+        std::vector<std::pair<int,int>> v;
+        for (int i : m_todo) v.emplace_back(i, m_seeds.count(i) ? m_seeds.at(i) : 0);
+        return v;
+    }
+
+    //! @brief whether the sweep is completed
+    bool done() const {
+        return m_todo.empty();
+    }
+
+    //! @brief total number of point evaluations (each with a batch of seeds) requested so far
+    size_t evaluations() const {
+        return m_evaluations;
+    }
+
+    /**
+     * @brief Refines the sweep given the measures after the last step.
+     *
+     * @param measure A function associating to a grid point the bands of the curves in that point.
+     */
+    template <typename F>
+    void refine(F&& measure) {
+        m_evaluations += m_todo.size();
+        for (int i : m_todo) ++m_seeds[i];
+        m_todo.clear();
+        std::vector<int> xs;
+        std::vector<std::vector<band_point>> ys;
+        for (auto const& kv : m_seeds) {
+            xs.push_back(kv.first);
+            ys.push_back(measure(kv.first));
+        }
+        std::vector<int> add;
+        size_t curves = ys.empty() ? 0 : ys[0].size();
+        for (size_t c=0; c<curves; ++c) {
+            double lo = INFINITY, hi = -INFINITY;
+            for (auto const& y : ys) if (not std::isnan(y[c].mean)) {
+                lo = std::min(lo, y[c].mean);
+                hi = std::max(hi, y[c].mean);
+            }
+            double tol = m_tolerance * std::max(hi - lo, c < m_scales.size() ? m_scales[c] : 1e-9);
+            for (size_t i=0; i<xs.size(); ++i) {
+                // wide confidence interval: more seeds in the point
+                if (ys[i][c].high - ys[i][c].low > 2*tol and m_seeds[xs[i]] < m_max_seeds) add.push_back(xs[i]);
+                if (i == 0 or i+1 == xs.size()) continue;
+                // bending curve: more points in the neighbouring intervals
+                double f = double(xs[i] - xs[i-1]) / (xs[i+1] - xs[i-1]);
+                double lerp = ys[i-1][c].mean + f * (ys[i+1][c].mean - ys[i-1][c].mean);
+                if (std::abs(ys[i][c].mean - lerp) > tol) {
+                    if (xs[i] - xs[i-1] > 1) add.push_back((xs[i-1] + xs[i]) / 2);
+                    if (xs[i+1] - xs[i] > 1) add.push_back((xs[i] + xs[i+1]) / 2);
+                }
+            }
+        }
+        std::sort(add.begin(), add.end());
+        add.erase(std::unique(add.begin(), add.end()), add.end());
+        m_todo = add;
+    }
+
+  private:
+    //! @brief scale of each curve
+    std::vector<double> m_scales;
+    //! @brief relative tolerance
+    double m_tolerance;
+    //! @brief maximum number of seed batches for a point
+    int m_max_seeds;
+    //! @brief total point evaluations
+    size_t m_evaluations = 0;
+    //! @brief points to be evaluated in the next step
+    std::vector<int> m_todo;
+    //! @brief number of seed batches evaluated for every point
+    std::map<int, int> m_seeds;
+};
+
+
+}
+
+#endif // FCPP_ADAPTIVE_SWEEP_H_
@@ -0,0 +1,46 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+#include <cstdlib>
+#include <new>
+
+#include "lib/alloc_stats.hpp"
+
+
+#ifdef ELECTION_ALLOC_STATS
+//! @cond INTERNAL
+// allocation functions are replaced, so that freeing what they allocate through malloc is correct
+#if defined(__GNUC__) && __GNUC__ >= 11 && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(size_t n) {
+    fcpp::alloc_stats::allocation();
+    void* p = std::malloc(n ? n : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t n) {
+    return operator new(n);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+#if defined(__GNUC__) && __GNUC__ >= 11 && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+//! @endcond
+#endif
@@ -0,0 +1,81 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file alloc_stats.hpp
+ * @brief Measurement of allocations and memory usage.
+ *
+ * If `ELECTION_ALLOC_STATS` is defined, allocations and node rounds are counted, through global
+ * allocation functions replaced in lib/alloc_stats.cpp, which should be linked with programs
+ * including this header.
+ */
+
+#ifndef FCPP_ALLOC_STATS_H_
+#define FCPP_ALLOC_STATS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Counters of allocations and rounds.
+struct alloc_stats {
+    //! @brief number of allocations
+    static std::atomic<uint64_t>& allocations() {
+        static std::atomic<uint64_t> n{0};
+        return n;
+    }
+
+    //! @brief number of node rounds
+    static std::atomic<uint64_t>& rounds() {
+        static std::atomic<uint64_t> n{0};
+        return n;
+    }
+
+    //! @brief counts an allocation (if enabled)
+    static void allocation() {
+#ifdef ELECTION_ALLOC_STATS
+        allocations().fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    //! @brief counts a node round (if enabled)
+    static void round() {
+#ifdef ELECTION_ALLOC_STATS
+        rounds().fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    //! @brief peak resident set size of the process (in KB, zero if unknown)
+    static long peak_rss() {
+#ifndef _WIN32
+        struct rusage r;
+        if (getrusage(RUSAGE_SELF, &r) == 0) return r.ru_maxrss;
+#endif
+        return 0;
+    }
+
+    //! @brief prints a summary of the statistics
+    static void summary(std::ostream& o) {
+#ifdef ELECTION_ALLOC_STATS
+        uint64_t a = allocations(), r = rounds();
+        o << "allocations per round: " << (r > 0 ? double(a) / r : 0.0) << " (" << r << " rounds), ";
+#endif
+        o << "peak RSS: " << peak_rss() << " KB" << std::endl;
+    }
+};
+
+
+}
+
+#endif // FCPP_ALLOC_STATS_H_
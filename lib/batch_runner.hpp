@@ -0,0 +1,438 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file batch_runner.hpp
+ * @brief Sharded and resumable execution of batch simulation sequences.
+ */
+
+#ifndef FCPP_BATCH_RUNNER_H_
+#define FCPP_BATCH_RUNNER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lib/delta_log.hpp"
+#include "lib/ensemble.hpp"
+#include "lib/fcpp.hpp"
+#include "lib/phase_timers.hpp"
+#include "lib/run_log.hpp"
+#include "lib/telemetry.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Options controlling a batch execution.
+struct batch_options {
+    //! @brief index of the shard to be run
+    size_t shard = 0;
+    //! @brief total number of shards
+    size_t shards = 1;
+    //! @brief whether runs with a complete log should be collected instead of executed
+    bool resume = false;
+    //! @brief whether existing logs should only be collected, executing no run
+    bool merge = false;
+    //! @brief whether a log file should be written for every run
+    bool files = false;
+    //! @brief number of threads executing runs
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    //! @brief path of a mobility trace driving devices (if any)
+    std::string mobility;
+    //! @brief path of the JSON-lines file receiving the telemetry of runs (if any)
+    std::string telemetry;
+    //! @brief seconds between progress reports, interleaving seeds across configurations (zero for none)
+    double progressive = 0;
+    //! @brief side of a single large simulation, whose nodes are processed by all threads (zero for none)
+    size_t large = 0;
+    //! @brief seed of the large simulation
+    uint32_t large_seed = 0;
+    //! @brief density of the large simulation (average number of neighbours)
+    size_t large_dens = 10;
+    //! @brief number of seeds of a configuration hosted as replicas by a single network (zero for none)
+    size_t ensemble = 0;
+};
+
+
+//! @brief Parses batch options from the command line (exiting on malformed arguments).
+batch_options parse_options(int argc, char** argv, bool files = false, std::string telemetry = "") {
+    batch_options opt;
+    opt.files = files;
+    opt.telemetry = telemetry;
+    auto usage = [&](){
+        std::cerr << "usage: " << argv[0] << " [--shard i/n] [--resume] [--merge] [--files] [--threads k] [--mobility trace] [--telemetry file] [--progressive seconds] [--large side [--seed k] [--dens d]] [--ensemble replicas]" << std::endl;
+        std::exit(1);
+    };
+    bool large_params = false;
+    for (int i=1; i<argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--shard" and i+1 < argc) {
+            std::string s = argv[++i];
+            size_t k = s.find('/');
+            if (k == std::string::npos) usage();
+            opt.shard = std::stoul(s.substr(0, k));
+            opt.shards = std::stoul(s.substr(k+1));
+            if (opt.shards == 0 or opt.shard >= opt.shards) usage();
+        } else if (arg == "--threads" and i+1 < argc) {
+            opt.threads = std::max(std::stoul(argv[++i]), 1ul);
+        } else if (arg == "--mobility" and i+1 < argc) {
+            opt.mobility = argv[++i];
+        } else if (arg == "--telemetry" and i+1 < argc) {
+            opt.telemetry = argv[++i];
+        } else if (arg == "--progressive" and i+1 < argc) {
+            opt.progressive = std::max(std::stod(argv[++i]), 0.0);
+        } else if (arg == "--large" and i+1 < argc) {
+            opt.large = std::stoul(argv[++i]);
+        } else if (arg == "--seed" and i+1 < argc) {
+            opt.large_seed = std::stoul(argv[++i]);
+            large_params = true;
+        } else if (arg == "--dens" and i+1 < argc) {
+            opt.large_dens = std::stoul(argv[++i]);
+            if (opt.large_dens == 0) usage();
+            large_params = true;
+        } else if (arg == "--ensemble" and i+1 < argc) {
+            opt.ensemble = std::stoul(argv[++i]);
+        } else if (arg == "--resume") opt.resume = true;
+        else if (arg == "--merge") opt.merge = true;
+        else if (arg == "--files") opt.files = true;
+        else usage();
+    }
+    // sharding, resuming and merging rely on the logs of single runs
+    opt.files |= opt.shards > 1 or opt.resume or opt.merge;
+    // ensembles write no logs of single runs, and replicas would share the devices of a mobility trace
+    if (opt.ensemble > 0 and (opt.files or opt.large > 0 or opt.mobility.size())) usage();
+    // the seed and density only apply to the large simulation
+    if (large_params and opt.large == 0) usage();
+    return opt;
+}
+
+
+/**
+ * @brief Runs slices of batch sequences, collecting the results of already completed runs.
+ *
+ * Sequences passed to successive calls of `run` are numbered consecutively, and shard `i` out of `n`
+ * executes the runs whose global index is `i` modulo `n`, so that shards are deterministic and balanced.
+ * When resuming or merging, runs with a complete log are not executed: their rows are fed to the plotter
+ * instead, with the key tags `K` taken from the parameters and the columns `C` from the log.
+ * Executed runs are recorded in the telemetry, with the parameters `K` and `P` (and the phase totals of
+ * the run if timers are enabled, which are also appended to its log).
+ * The outputs of runs are released as soon as the runs end, closing their change-only logs.
+ * In progressive mode, runs are executed interleaving the configurations (identified by `K`), so that
+ * every configuration gets its first seeds before any gets further ones, and a progress report is
+ * called at regular intervals while runs complete.
+ *
+ * @param K The sequence of tags identifying a configuration in the plotter rows.
+ * @param C The sequence of tags of the logged columns (in log order).
+ * @param P The sequence of further tags of parameters recorded in the telemetry.
+ */
+template <typename K, typename C, typename P = common::type_sequence<>>
+class batch_runner;
+
+//! @cond INTERNAL
+template <typename... Ks, typename... Cs, typename... Ps>
+class batch_runner<common::type_sequence<Ks...>, common::type_sequence<Cs...>, common::type_sequence<Ps...>> {
+  public:
+    //! @brief constructor given the options and the names of the parameters recorded in the telemetry (`K` and `P`)
+    batch_runner(batch_options const& opt, std::vector<std::string> names = {}) : m_opt(opt), m_names(names), m_telemetry(opt.telemetry) {}
+
+    //! @brief runs the slice of some sequences with a given simulator type
+    template <typename T, typename... Ss>
+    void run(T, Ss const&... vs) {
+        int expand[] = {0, (run_sequence(T{}, vs), 0)...};
+        (void)expand;
+    }
+
+    /**
+     * @brief Runs some sequences with a given simulator type, hosting up to `replicas` seeds of a configuration in every network.
+     *
+     * Runs differing only in their seed are grouped into ensembles, whose replicas are sampled by an
+     * `ensemble_monitor` and fed to the plotter of every run as if executed separately. The networks
+     * spawn the devices given by the tag `N` for every replica, and are sampled until the time given
+     * by the tag `E`. Ensembles write no logs, and execute the whole sequences (with no sharding).
+     */
+    template <typename N, typename E, typename T, typename... Ss>
+    void run_ensemble(T, size_t replicas, Ss const&... vs) {
+        int expand[] = {0, (run_ensemble_sequence<N, E>(T{}, std::max(replicas, size_t(1)), vs), 0)...};
+        (void)expand;
+    }
+
+    //! @brief the options
+    batch_options const& options() const {
+        return m_opt;
+    }
+
+    //! @brief sets the progress report, called in progressive mode at most once every `progressive` seconds
+    void on_progress(std::function<void()> f) {
+        m_progress = f;
+    }
+
+    //! @brief prints a summary of the execution
+    void summary(std::ostream& o) const {
+        o << "shard " << m_opt.shard << "/" << m_opt.shards << ": " << m_executed << " runs executed, " << m_collected << " collected";
+        if (m_missing > 0) o << ", " << m_missing << " missing";
+        o << std::endl;
+    }
+
+  private:
+    //! @brief runs the slice of a sequence
+    template <typename T, typename S>
+    void run_sequence(T, S const& v) {
+        std::vector<size_t> todo;
+        for (size_t i=0; i<v.size(); ++i, ++m_offset) {
+            if (not m_opt.merge and m_offset % m_opt.shards != m_opt.shard) continue;
+            if (m_opt.resume or m_opt.merge) {
+                auto t = v[i];
+                std::string path = output_path(common::get<component::tags::output>(t));
+                release_output(common::get<component::tags::output>(t));
+                if (log_complete(path)) {
+                    read_log(path, [&](std::vector<double> const& row){
+                        collect(t, row, std::make_index_sequence<sizeof...(Cs)>{});
+                    });
+                    ++m_collected;
+                    continue;
+                }
+                if (m_opt.merge) {
+                    std::cerr << "missing log: " << path << std::endl;
+                    ++m_missing;
+                    continue;
+                }
+            }
+            todo.push_back(i);
+        }
+        if (m_opt.progressive > 0) interleave(v, todo);
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> pool;
+        m_telemetry.start(todo.size());
+        for (size_t k=0; k<std::min(m_opt.threads, todo.size()); ++k)
+            pool.emplace_back([&](){
+                run_telemetry::runner() = true;
+                for (size_t j; (j = next++) < todo.size(); ) {
+                    auto t = v[todo[j]];
+                    run_telemetry::clock_t::time_point start = run_telemetry::clock_t::now();
+                    uint64_t rounds = run_telemetry::run_rounds();
+                    {
+                        typename T::net network{t};
+                        network.run();
+                    }
+                    double seconds = std::chrono::duration<double>(run_telemetry::clock_t::now() - start).count();
+                    std::string fields = params(t);
+                    if (phase_timers::enabled()) {
+                        // the phase totals go both to the log of the run and to its telemetry
+                        phase_timers::totals phases = phase_timers::take(seconds);
+                        log_comment(common::get<component::tags::output>(t), phase_timers::comment(phases, seconds));
+                        fields += (fields.size() ? ", " : "") + phase_timers::json(phases, seconds);
+                    }
+                    release_output(common::get<component::tags::output>(t));
+                    m_telemetry.record(fields, seconds, run_telemetry::run_rounds() - rounds);
+                    progress();
+                }
+            });
+        for (std::thread& t : pool) t.join();
+        m_executed += todo.size();
+    }
+
+    //! @brief runs a sequence grouping its seeds into ensembles
+    template <typename N, typename E, typename T, typename S>
+    void run_ensemble_sequence(T, size_t replicas, S const& v) {
+        // groups runs by configuration, in order of appearance
+        std::map<std::vector<double>, size_t> open;
+        std::vector<std::vector<size_t>> ensembles;
+        for (size_t i=0; i<v.size(); ++i, ++m_offset) {
+            auto t = v[i];
+            release_output(common::get<component::tags::output>(t));
+            std::vector<double> key{double(common::get<Ks>(t))..., configuration<Ps>(t)...};
+            auto it = open.find(key);
+            if (it == open.end() or ensembles[it->second].size() >= replicas) {
+                open[key] = ensembles.size();
+                ensembles.emplace_back();
+            }
+            ensembles[open[key]].push_back(i);
+        }
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> pool;
+        m_telemetry.start(v.size());
+        for (size_t k=0; k<std::min(m_opt.threads, ensembles.size()); ++k)
+            pool.emplace_back([&](){
+                run_telemetry::runner() = true;
+                for (size_t j; (j = next++) < ensembles.size(); ) {
+                    std::vector<size_t> const& e = ensembles[j];
+                    auto t = v[e[0]];
+                    // the rows of the network merge all replicas, and are discarded
+                    typename std::remove_pointer<std::decay_t<decltype(common::get<component::tags::plotter>(t))>>::type merged;
+                    common::get<component::tags::plotter>(t) = &merged;
+                    std::vector<uint32_t> seeds;
+                    for (size_t i : e) seeds.push_back(common::get<component::tags::seed>(v[i]));
+                    ensemble_monitor monitor(seeds, common::get<N>(t), common::get<E>(t));
+                    run_telemetry::clock_t::time_point start = run_telemetry::clock_t::now();
+                    uint64_t rounds = run_telemetry::run_rounds();
+                    ensemble_monitor::active() = &monitor;
+                    {
+                        typename T::net network{t};
+                        network.run();
+                    }
+                    ensemble_monitor::active() = nullptr;
+                    monitor.finish();
+                    double seconds = std::chrono::duration<double>(run_telemetry::clock_t::now() - start).count();
+                    rounds = run_telemetry::run_rounds() - rounds;
+                    std::string phases;
+                    if (phase_timers::enabled()) phases = ", " + phase_timers::json(phase_timers::take(seconds), seconds);
+                    for (size_t r=0; r<e.size(); ++r) {
+                        auto u = v[e[r]];
+                        {
+                            std::lock_guard<std::mutex> lock(m_collect_mutex);
+                            for (std::vector<double> const& row : monitor.rows(r))
+                                collect(u, row, std::make_index_sequence<sizeof...(Cs)>{});
+                        }
+                        // replicas share the time and rounds of their network, whose phase totals are recorded with the first replica
+                        std::string fields = params(u);
+                        fields += (fields.size() ? ", " : "") + std::string("\"replicas\": ") + std::to_string(e.size()) + (r == 0 ? phases : "");
+                        m_telemetry.record(fields, seconds / e.size(), rounds / e.size());
+                    }
+                    progress();
+                }
+            });
+        for (std::thread& t : pool) t.join();
+        m_executed += v.size();
+    }
+
+    //! @brief the value of a parameter of a run identifying its configuration (none for the seed)
+    template <typename P, typename T>
+    static double configuration(T const& t) {
+        return std::is_same<P, component::tags::seed>::value ? 0 : double(common::get<P>(t));
+    }
+
+    //! @brief reorders runs of a sequence, so that the i-th run of every configuration comes before the (i+1)-th run of any
+    template <typename S>
+    void interleave(S const& v, std::vector<size_t>& todo) {
+        std::map<std::vector<double>, size_t> seen;
+        std::vector<size_t> rank(todo.size());
+        for (size_t j=0; j<todo.size(); ++j) {
+            auto t = v[todo[j]];
+            rank[j] = seen[std::vector<double>{double(common::get<Ks>(t))...}]++;
+            release_output(common::get<component::tags::output>(t));
+        }
+        std::vector<size_t> order(todo.size());
+        for (size_t j=0; j<order.size(); ++j) order[j] = j;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return rank[a] < rank[b]; });
+        std::vector<size_t> sorted;
+        for (size_t j : order) sorted.push_back(todo[j]);
+        todo.swap(sorted);
+    }
+
+    //! @brief calls the progress report, if enough time passed since the last call
+    void progress() {
+        if (m_opt.progressive <= 0 or not m_progress) return;
+        std::unique_lock<std::mutex> lock(m_progress_mutex, std::try_to_lock);
+        if (not lock.owns_lock()) return;
+        run_telemetry::clock_t::time_point now = run_telemetry::clock_t::now();
+        if (now - m_last_progress < std::chrono::duration<double>(m_opt.progressive)) return;
+        m_last_progress = now;
+        m_progress();
+    }
+
+    //! @brief feeds a logged row to the plotter of a run
+    template <typename T, size_t... is>
+    void collect(T const& t, std::vector<double> const& row, std::index_sequence<is...>) {
+        if (row.size() <= sizeof...(Cs)) return;
+        *common::get<component::tags::plotter>(t) << common::make_tagged_tuple<Ks..., plot::time, Cs...>(
+            common::get<Ks>(t)..., row[0], row[is+1]...
+        );
+    }
+
+    //! @brief the parameters of a run, as JSON fields
+    template <typename T>
+    std::string params(T const& t) const {
+        std::stringstream ss;
+        ss << std::boolalpha;
+        print_params(ss, t, 0, common::type_sequence<Ks...>{}, std::make_index_sequence<sizeof...(Ks)>{});
+        print_params(ss, t, sizeof...(Ks), common::type_sequence<Ps...>{}, std::make_index_sequence<sizeof...(Ps)>{});
+        return ss.str();
+    }
+
+    //! @brief prints some parameters of a run, as JSON fields
+    template <typename T, typename... Ts, size_t... is>
+    void print_params(std::ostream& o, T const& t, size_t offset, common::type_sequence<Ts...>, std::index_sequence<is...>) const {
+        int expand[] = {0, (o << (offset + is ? ", " : "") << "\"" << name(offset + is) << "\": " << common::get<Ts>(t), 0)...};
+        (void)expand;
+    }
+
+    //! @brief the name of a parameter recorded in the telemetry
+    std::string name(size_t i) const {
+        return i < m_names.size() ? m_names[i] : "p" + std::to_string(i);
+    }
+
+    //! @brief the log path of a run logging on file
+    static std::string output_path(std::string const& s) {
+        return s;
+    }
+
+    //! @brief the log path of a run logging on a stream (only change-only logs have a path)
+    static std::string output_path(std::ostream* o) {
+        delta_log const* d = dynamic_cast<delta_log const*>(o);
+        return d ? d->path() : "";
+    }
+
+    //! @brief releases the output of a run logging on a stream, once the run is over (closing change-only logs)
+    static void release_output(std::ostream* o) {
+        if (delta_log* d = dynamic_cast<delta_log*>(o)) d->release();
+    }
+
+    //! @brief releases the output of a run logging on something else (nothing to do)
+    template <typename O>
+    static void release_output(O const&) {}
+
+    //! @brief appends a comment line to the log of a run logging on a stream
+    static void log_comment(std::ostream* o, std::string const& s) {
+        *o << s << std::endl;
+    }
+
+    //! @brief appends a comment line to the log of a run logging on something else (not possible)
+    template <typename O>
+    static void log_comment(O const&, std::string const&) {}
+
+    //! @brief the log path of a run logging on something else (no path)
+    template <typename O, typename = std::enable_if_t<not std::is_convertible<O, std::string>::value>>
+    static std::string output_path(O const&) {
+        return "";
+    }
+
+    //! @brief the options
+    batch_options m_opt;
+    //! @brief the names of the parameters recorded in the telemetry
+    std::vector<std::string> m_names;
+    //! @brief the telemetry of runs
+    run_telemetry m_telemetry;
+    //! @brief global index of the next run
+    size_t m_offset = 0;
+    //! @brief counters of runs executed, collected from logs, and missing
+    size_t m_executed = 0, m_collected = 0, m_missing = 0;
+    //! @brief the progress report
+    std::function<void()> m_progress;
+    //! @brief mutex regulating progress reports
+    std::mutex m_progress_mutex;
+    //! @brief mutex regulating the rows of ensembles fed to plotters
+    std::mutex m_collect_mutex;
+    //! @brief time of the last progress report
+    run_telemetry::clock_t::time_point m_last_progress = run_telemetry::clock_t::now();
+};
+//! @endcond
+
+
+}
+
+#endif // FCPP_BATCH_RUNNER_H_
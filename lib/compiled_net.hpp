@@ -0,0 +1,104 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file compiled_net.hpp
+ * @brief Networks of simulators with a fixed initialisation type, which can be compiled once.
+ */
+
+#ifndef FCPP_COMPILED_NET_H_
+#define FCPP_COMPILED_NET_H_
+
+#include <memory>
+
+#include "lib/fcpp.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Copies into a tagged tuple the values of its tags in another tagged tuple (containing them).
+template <typename... Ss, typename... Us, typename T>
+void assign_tags(common::tagged_tuple<common::type_sequence<Ss...>, common::type_sequence<Us...>>& r, T const& t) {
+    int expand[] = {0, (common::get<Ss>(r) = common::get<Ss>(t), 0)...};
+    (void)expand;
+}
+
+
+/**
+ * @brief Network of a simulator `S` initialised by parameters of type `I`.
+ *
+ * Since the network is only accessed through non-inline members, whose definitions do not depend on
+ * the parameters used by callers, declaring an `extern template` for a specialisation allows it to be
+ * explicitly instantiated (and compiled) once in a separate translation unit.
+ *
+ * @param S The simulator type (with a nested `net` type).
+ * @param I The tagged tuple type of the initialisation parameters.
+ */
+template <typename S, typename I>
+class compiled_net {
+  public:
+    //! @brief constructor given the initialisation parameters
+    compiled_net(I const& t);
+
+    //! @brief constructor given any tagged tuple containing the initialisation parameters
+    template <typename T>
+    compiled_net(T const& t) : compiled_net(convert(t)) {}
+
+    //! @brief destructor
+    ~compiled_net();
+
+    //! @brief runs the simulation
+    void run();
+
+  private:
+    //! @brief the network of the simulator
+    struct impl;
+
+    //! @brief converts a tagged tuple to the initialisation type
+    template <typename T>
+    static I convert(T const& t) {
+        I r;
+        assign_tags(r, t);
+        return r;
+    }
+
+    //! @brief the network of the simulator
+    std::unique_ptr<impl> m_impl;
+};
+
+
+//! @cond INTERNAL
+template <typename S, typename I>
+struct compiled_net<S, I>::impl {
+    impl(I const& t) : net(t) {}
+
+    typename S::net net;
+};
+
+template <typename S, typename I>
+compiled_net<S, I>::compiled_net(I const& t) : m_impl(new impl(t)) {}
+
+template <typename S, typename I>
+compiled_net<S, I>::~compiled_net() = default;
+
+template <typename S, typename I>
+void compiled_net<S, I>::run() {
+    m_impl->net.run();
+}
+//! @endcond
+
+
+//! @brief Simulator type whose networks are of type `compiled_net<S, I>`.
+template <typename S, typename I>
+struct compiled_simulator {
+    //! @brief the network type
+    using net = compiled_net<S, I>;
+};
+
+
+}
+
+#endif // FCPP_COMPILED_NET_H_
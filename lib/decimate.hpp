@@ -0,0 +1,180 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file decimate.hpp
+ * @brief Shape-preserving decimation of the series in plot files, bounding their size.
+ */
+
+#ifndef FCPP_DECIMATE_H_
+#define FCPP_DECIMATE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief A point of a series, with the text representing it.
+struct series_point {
+    //! @brief coordinates
+    double x, y;
+    //! @brief text of the point
+    std::string text;
+};
+
+
+//! @brief Decimation algorithms.
+enum class decimation { lttb, envelope };
+
+
+/**
+ * @brief Largest-triangle-three-buckets decimation of a series to at most `n` points.
+ *
+ * Non-finite values mark discontinuities: the first of every run of them is kept, counting against
+ * the budget. If the discontinuities do not fit in the budget, every bucket keeps a single point,
+ * its first discontinuity if any.
+ */
+inline std::vector<series_point> lttb(std::vector<series_point> const& v, size_t n) {
+    if (n < 3 or v.size() <= n) return v;
+    std::vector<bool> gap(v.size(), false);
+    size_t gaps = 0;
+    for (size_t i=1; i+1<v.size(); ++i) if (not std::isfinite(v[i].y) and std::isfinite(v[i-1].y)) {
+        gap[i] = true;
+        ++gaps;
+    }
+    bool room = gaps + 2 < n;
+    size_t buckets = room ? n - gaps - 2 : n - 2;
+    std::vector<series_point> r;
+    r.push_back(v.front());
+    double step = double(v.size() - 2) / buckets;
+    size_t a = 0;
+    for (size_t b=0; b<buckets; ++b) {
+        // current bucket [lo,hi), next bucket [hi,nhi)
+        size_t lo = 1 + size_t(b * step), hi = 1 + size_t((b+1) * step), nhi = std::min(1 + size_t((b+2) * step), v.size());
+        if (b+1 == buckets) {
+            hi = v.size() - 1;
+            nhi = v.size();
+        }
+        double ax = 0, ay = 0;
+        size_t cnt = 0;
+        for (size_t i=hi; i<nhi; ++i) if (std::isfinite(v[i].y)) {
+            ax += v[i].x;
+            ay += v[i].y;
+            ++cnt;
+        }
+        if (cnt > 0) {
+            ax /= cnt;
+            ay /= cnt;
+        } else {
+            ax = v.back().x;
+            ay = v.back().y;
+        }
+        size_t best = lo;
+        double area = -1;
+        for (size_t i=lo; i<hi; ++i) if (std::isfinite(v[i].y)) {
+            double s = std::abs((v[a].x - ax) * (v[i].y - v[a].y) - (v[a].x - v[i].x) * (ay - v[a].y));
+            if (s > area) {
+                area = s;
+                best = i;
+            }
+        }
+        // the points kept in the bucket are emitted in their original order
+        size_t first = std::find(gap.begin() + lo, gap.begin() + hi, true) - gap.begin();
+        if (room) {
+            for (size_t i=lo; i<hi; ++i) if (gap[i] or (area >= 0 and i == best)) r.push_back(v[i]);
+        } else if (first < hi) r.push_back(v[first]);
+        else if (area >= 0) r.push_back(v[best]);
+        if (area >= 0 and (room or first == hi)) a = best;
+    }
+    r.push_back(v.back());
+    return r;
+}
+
+//! @brief Min/max envelope decimation of a series to (about) `n` points.
+inline std::vector<series_point> envelope(std::vector<series_point> const& v, size_t n) {
+    if (n < 4 or v.size() <= n) return v;
+    std::vector<series_point> r;
+    size_t buckets = n / 2;
+    double step = double(v.size()) / buckets;
+    for (size_t b=0; b<buckets; ++b) {
+        size_t lo = size_t(b * step), hi = std::min(size_t((b+1) * step), v.size());
+        size_t mn = lo, mx = lo;
+        for (size_t i=lo; i<hi; ++i) {
+            if (not std::isfinite(v[i].y)) continue;
+            if (not std::isfinite(v[mn].y) or v[i].y < v[mn].y) mn = i;
+            if (not std::isfinite(v[mx].y) or v[i].y > v[mx].y) mx = i;
+        }
+        // the extremes are kept in their original order
+        r.push_back(v[std::min(mn, mx)]);
+        if (mn != mx) r.push_back(v[std::max(mn, mx)]);
+    }
+    return r;
+}
+
+
+//! @brief Parses a series in the form `{(x, y), ...}` starting at a position, which is moved after the series.
+inline std::vector<series_point> parse_series(std::string const& s, size_t& pos) {
+    std::vector<series_point> v;
+    pos = s.find('{', pos) + 1;
+    while (pos < s.size() and s[pos] != '}') {
+        size_t open = s.find('(', pos), close = s.find(')', open);
+        std::string text = s.substr(open, close - open + 1);
+        size_t comma = text.find(',');
+        v.push_back({std::strtod(text.c_str() + 1, nullptr), std::strtod(text.c_str() + comma + 1, nullptr), text});
+        pos = close + 1;
+        while (pos < s.size() and (s[pos] == ',' or s[pos] == ' ')) ++pos;
+    }
+    ++pos;
+    return v;
+}
+
+/**
+ * @brief Decimates every plot in a plot file, so that each plot has at most `budget` points.
+ *
+ * The budget of a plot is split evenly among its series.
+ */
+inline std::string decimate(std::string const& file, size_t budget, decimation mode = decimation::lttb) {
+    static const std::string marker = "new pair[][] {";
+    std::stringstream out;
+    size_t pos = 0;
+    for (size_t next; (next = file.find(marker, pos)) != std::string::npos; ) {
+        next += marker.size();
+        out << file.substr(pos, next - pos);
+        std::vector<std::vector<series_point>> series;
+        pos = next;
+        while (file[pos] == '{') {
+            series.push_back(parse_series(file, pos));
+            while (file[pos] == ',' or file[pos] == ' ') ++pos;
+        }
+        size_t n = budget / std::max(series.size(), size_t(1));
+        for (size_t i=0; i<series.size(); ++i) {
+            std::vector<series_point> v = mode == decimation::lttb ? lttb(series[i], n) : envelope(series[i], n);
+            out << (i ? ", " : "") << "{";
+            for (size_t j=0; j<v.size(); ++j) out << (j ? ", " : "") << v[j].text;
+            out << "}";
+        }
+    }
+    out << file.substr(pos);
+    return out.str();
+}
+
+//! @brief Decimates every plot in a printable plot file.
+template <typename T>
+std::string decimate(T const& file, size_t budget, decimation mode = decimation::lttb) {
+    std::stringstream ss;
+    ss << file;
+    return decimate(ss.str(), budget, mode);
+}
+
+
+}
+
+#endif // FCPP_DECIMATE_H_
@@ -0,0 +1,205 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file delta_log.hpp
+ * @brief Change-only logging of simulation runs, omitting rows equal to the previous ones.
+ */
+
+#ifndef FCPP_DELTA_LOG_H_
+#define FCPP_DELTA_LOG_H_
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+
+#include "lib/phase_timers.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Prefix of the comment line marking a change-only log (followed by the export period and the keyframe period).
+constexpr char const* delta_log_marker = "# delta log with period and keyframes:";
+
+
+/**
+ * @brief Stream buffer writing a log on file, omitting data rows whose values (apart from time) are
+ * equal to those of the last row written.
+ *
+ * A row is written anyways if `keyframe` time units have passed since the last row written, and the
+ * last row before a comment is always written, so that the time span of the log is preserved.
+ * The file is opened at the first write, and starts with a marker line allowing `read_log` to
+ * expand the omitted rows given the `period` between rows.
+ */
+class delta_log_buffer : public std::streambuf {
+  public:
+    //! @brief constructor given the path, the period between rows and the keyframe period
+    delta_log_buffer(std::string const& path, double period, double keyframe) : m_path(path), m_period(period), m_keyframe(keyframe) {}
+
+    //! @brief the path of the log
+    std::string const& path() const {
+        return m_path;
+    }
+
+  protected:
+    //! @brief writes a character
+    int overflow(int c) override {
+        if (c == EOF) return 0;
+        if (c == '\n') line();
+        else m_line.push_back(c);
+        return c;
+    }
+
+    //! @brief writes a sequence of characters
+    std::streamsize xsputn(char const* s, std::streamsize n) override {
+        for (std::streamsize i=0; i<n; ++i) overflow(s[i]);
+        return n;
+    }
+
+    //! @brief flushes the file
+    int sync() override {
+        m_out.flush();
+        return 0;
+    }
+
+  private:
+    //! @brief processes a complete line
+    void line() {
+        phase_timer timer(phase::logging);
+        if (not m_out.is_open()) {
+            m_out.open(m_path);
+            m_out << delta_log_marker << " " << m_period << " " << m_keyframe << "\n";
+        }
+        if (m_line.empty() or m_line[0] == '#') {
+            flush_pending();
+            m_out << m_line << "\n";
+        } else {
+            size_t k = m_line.find(' ');
+            double t = std::stod(m_line.substr(0, k));
+            std::string values = k == std::string::npos ? "" : m_line.substr(k);
+            if (m_written and values == m_values and t < m_time + m_keyframe) {
+                m_pending = m_line;
+            } else {
+                m_pending.clear();
+                m_out << m_line << "\n";
+                m_values = values;
+                m_time = t;
+                m_written = true;
+            }
+        }
+        m_line.clear();
+    }
+
+    //! @brief writes the last row omitted, if any
+    void flush_pending() {
+        if (m_pending.empty()) return;
+        m_out << m_pending << "\n";
+        m_pending.clear();
+    }
+
+    //! @brief the path of the log
+    std::string m_path;
+    //! @brief the period between rows
+    double m_period;
+    //! @brief the keyframe period
+    double m_keyframe;
+    //! @brief the output file
+    std::ofstream m_out;
+    //! @brief the line being written
+    std::string m_line;
+    //! @brief the last row omitted
+    std::string m_pending;
+    //! @brief the values in the last row written
+    std::string m_values;
+    //! @brief the time of the last row written
+    double m_time = 0;
+    //! @brief whether a row has been written
+    bool m_written = false;
+};
+
+
+class delta_log_pool;
+
+
+//! @brief Stream writing a change-only log on file.
+class delta_log : public std::ostream {
+  public:
+    //! @brief constructor given the path, the period between rows and the keyframe period (and the pool owning the log, if any)
+    delta_log(std::string const& path, double period, double keyframe, delta_log_pool* owner = nullptr) : std::ostream(nullptr), m_buffer(path, period, keyframe), m_owner(owner) {
+        rdbuf(&m_buffer);
+    }
+
+    //! @brief the path of the log
+    std::string const& path() const {
+        return m_buffer.path();
+    }
+
+    //! @brief closes the log when its run is over, destroying it if owned by a pool
+    inline void release();
+
+  private:
+    //! @brief the stream buffer
+    delta_log_buffer m_buffer;
+    //! @brief the pool owning the log (if any)
+    delta_log_pool* m_owner;
+};
+
+
+/**
+ * @brief Owner of the change-only logs of multiple runs, which need to outlive the runs.
+ *
+ * Logs are destroyed (closing their files) as soon as they are released, so that only the logs
+ * of the runs in progress are kept open.
+ */
+class delta_log_pool {
+  public:
+    //! @brief creates a new log
+    std::ostream* make(std::string const& path, double period, double keyframe) {
+        delta_log* d = new delta_log(path, period, keyframe, this);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_logs[d].reset(d);
+        return d;
+    }
+
+    //! @brief destroys a log
+    void release(delta_log const* d) {
+        std::unique_ptr<delta_log> p;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_logs.find(d);
+            if (it == m_logs.end()) return;
+            p = std::move(it->second);
+            m_logs.erase(it);
+        }
+    }
+
+    //! @brief number of logs not yet released
+    size_t size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_logs.size();
+    }
+
+  private:
+    //! @brief the logs
+    std::unordered_map<delta_log const*, std::unique_ptr<delta_log>> m_logs;
+    //! @brief mutex regulating concurrent creations and releases
+    std::mutex m_mutex;
+};
+
+
+void delta_log::release() {
+    if (m_owner != nullptr) m_owner->release(this);
+    else flush();
+}
+
+
+}
+
+#endif // FCPP_DELTA_LOG_H_
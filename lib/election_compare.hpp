@@ -8,9 +8,21 @@
 #ifndef FCPP_ELECTION_COMPARE_H_
 #define FCPP_ELECTION_COMPARE_H_
 
+#include "lib/alloc_stats.hpp"
 #include "lib/beautify.hpp"
 #include "lib/coordination/election.hpp"
 #include "lib/coordination/geometry.hpp"
+#include "lib/coordination/utils.hpp"
+#include "lib/ensemble.hpp"
+#include "lib/g_function.hpp"
+#include "lib/live_snapshot.hpp"
+#include "lib/neighbour_histogram.hpp"
+#include "lib/mobility_trace.hpp"
+#include "lib/phase_timers.hpp"
+#include "lib/philox.hpp"
+#include "lib/recovery_latency.hpp"
+#include "lib/telemetry.hpp"
+#include "lib/trace.hpp"
 
 
 /**
@@ -34,6 +46,14 @@ namespace tags {
     struct die_time {};
     //! @brief The time of simulation end.
     struct end_time {};
+    //! @brief The standard deviation in round length.
+    struct round_dev {};
+    //! @brief The seed of the simulation run, keying the counter-based random values.
+    struct run_seed {};
+    //! @brief The number of rounds executed by the node.
+    struct round_count {};
+    //! @brief The number of devices of every replica of an ensemble (of the whole network otherwise).
+    struct replica_size {};
 
     //! @brief The size of the node.
     struct node_size {};
@@ -52,6 +72,7 @@ namespace tags {
     struct correct {};
     template <typename T>
     struct spurious {};
+    struct neighbours {};
 
     struct GCF {};
     struct Datta {};
@@ -61,7 +82,7 @@ namespace tags {
 }
 
 //! @brief Converts a device uid to a color.
-color uid2col(device_t i) {
+inline color uid2col(device_t i) {
     real_t h = i * 0.06 + 1;
     h = 320 * (1 - 1 / h);
     real_t s = (i & 1) > 0 ? 0.5 : 1;
@@ -82,51 +103,138 @@ GEN(T) T stabiliser(ARGS, T value, int delay) { CODE
 
 //! @brief Computes several election algorithms for comparing them.
 MAIN() {
-    device_t GCF = wave_election(CALL);
-    device_t Datta = color_election(CALL);
-    device_t GCF__filtered = stabiliser(CALL, GCF, 4);
-    device_t Datta__filtered = stabiliser(CALL, Datta, 4);
+    // the replica of the node in an ensemble (zero otherwise), and its identifier within the replica
+    device_t size = node.storage(tags::replica_size{});
+    device_t replica = size > 0 ? node.uid / size : 0;
+    device_t uid = size > 0 ? node.uid % size : node.uid;
+    device_t base = node.uid - uid;
+    ensemble_monitor* ensemble = ensemble_monitor::active();
+
+    device_t GCF, Datta, GCF__filtered, Datta__filtered;
+    {
+        phase_timer timer(phase::election);
+        GCF = wave_election(CALL, node.uid, g_function{});
+        Datta = color_election(CALL);
+        GCF__filtered = stabiliser(CALL, GCF, 4);
+        Datta__filtered = stabiliser(CALL, Datta, 4);
+    }
+    // replicas are disconnected, so that their leaders are within them
+    GCF -= base;
+    Datta -= base;
+    GCF__filtered -= base;
+    Datta__filtered -= base;
 
     node.storage(tags::node_size{}) = 0.10;
     node.storage(tags::node_shape{}) = shape::cube;
-    if (Datta__filtered == node.uid) {
+    if (Datta__filtered == uid) {
         node.storage(tags::node_size{}) = 0.15;
         node.storage(tags::node_shape{}) = shape::icosahedron;
     }
-    if (GCF__filtered == node.uid) {
+    if (GCF__filtered == uid) {
         node.storage(tags::node_size{}) = 0.20;
         node.storage(tags::node_shape{}) = shape::sphere;
     }
     node.storage(tags::gcf_color{}) = uid2col(GCF__filtered);
     node.storage(tags::datta_color{}) = uid2col(Datta__filtered);
 
-    rectangle_walk(CALL, make_vec(0,0), make_vec(node.storage(tags::side{}),2), node.storage(tags::speed{})*0.01, 1);
+    alloc_stats::round();
+    run_telemetry::round();
+    {
+        phase_timer timer(phase::movement);
+        mobility_trace* mobility = mobility_trace::active();
+        if (mobility != nullptr and mobility->has(node.uid)) {
+            // reaches the traced position at the next round
+            std::array<double, 2> target = mobility->position(node.uid, node.current_time() + 1);
+            node.velocity() = make_vec(target[0], target[1]) - node.position();
+        } else {
+            double y = replica * ensemble_monitor::spacing;
+            rectangle_walk(CALL, make_vec(0,y), make_vec(node.storage(tags::side{}),y+2), node.storage(tags::speed{})*0.01, 1);
+        }
+    }
     bool perturbation = node.current_time() >= node.storage(tags::die_time{});
-    if (node.uid % 10 == 0 and perturbation) node.terminate();
     double E = node.storage(tags::end_time{});
-    if (node.current_time() > E + 2) node.terminate();
-    if (node.uid > 1 and node.current_time() < E - 20 and node.next_real()*100 < node.storage(tags::crash{})) {
+    bool alive = not (uid % 10 == 0 and perturbation) and node.current_time() <= E + 2;
+    if (not alive) node.terminate();
+    // random values keyed by (seed, uid, round), independent of the order of events (and of other replicas)
+    uint32_t key = ensemble != nullptr ? ensemble->seed(replica) : node.storage(tags::run_seed{});
+    uint32_t round = node.storage(tags::round_count{})++;
+    if (node.storage(tags::round_dev{}) > 0)
+        node.next_time(node.current_time() + counter_weibull(1, node.storage(tags::round_dev{}), key, uid, round, 1));
+    if (uid > 1 and node.current_time() < E - 20 and counter_real(key, uid, round, 0)*100 < node.storage(tags::crash{})) {
         node.velocity() /= 20;
         node.next_time(node.current_time() + 20);
         node.storage(tags::node_shape{}) = shape::tetrahedron;
     }
 
-    node.storage(tags::leaders<tags::GCF>{}) = GCF;
-    node.storage(tags::leaders<tags::Datta>{}) = Datta;
-    node.storage(tags::leaders<tags::GCF__filtered>{}) = GCF__filtered;
-    node.storage(tags::leaders<tags::Datta__filtered>{}) = Datta__filtered;
-
-    node.storage(tags::correct<tags::GCF>{}) = GCF == perturbation;
-    node.storage(tags::correct<tags::Datta>{}) = Datta == perturbation;
-    node.storage(tags::correct<tags::GCF__filtered>{}) = GCF__filtered == perturbation;
-    node.storage(tags::correct<tags::Datta__filtered>{}) = Datta__filtered == perturbation;
-
-    node.storage(tags::spurious<tags::GCF>{}) = GCF > perturbation;
-    node.storage(tags::spurious<tags::Datta>{}) = Datta > perturbation;
-    node.storage(tags::spurious<tags::GCF__filtered>{}) = GCF__filtered > perturbation;
-    node.storage(tags::spurious<tags::Datta__filtered>{}) = Datta__filtered > perturbation;
+    {
+        phase_timer timer(phase::instrumentation);
+        node.storage(tags::leaders<tags::GCF>{}) = GCF;
+        node.storage(tags::leaders<tags::Datta>{}) = Datta;
+        node.storage(tags::leaders<tags::GCF__filtered>{}) = GCF__filtered;
+        node.storage(tags::leaders<tags::Datta__filtered>{}) = Datta__filtered;
+
+        node.storage(tags::correct<tags::GCF>{}) = GCF == perturbation;
+        node.storage(tags::correct<tags::Datta>{}) = Datta == perturbation;
+        node.storage(tags::correct<tags::GCF__filtered>{}) = GCF__filtered == perturbation;
+        node.storage(tags::correct<tags::Datta__filtered>{}) = Datta__filtered == perturbation;
+
+        node.storage(tags::spurious<tags::GCF>{}) = GCF > perturbation;
+        node.storage(tags::spurious<tags::Datta>{}) = Datta > perturbation;
+        node.storage(tags::spurious<tags::GCF__filtered>{}) = GCF__filtered > perturbation;
+        node.storage(tags::spurious<tags::Datta__filtered>{}) = Datta__filtered > perturbation;
+    }
+    int nbr_size;
+    {
+        phase_timer timer(phase::neighbourhood);
+        nbr_size = count_hood(CALL) - 1;
+        node.storage(tags::neighbours{}) = nbr_size;
+    }
+    {
+        phase_timer timer(phase::monitoring);
+        neighbour_histogram().insert(nbr_size);
+        if (recovery_monitor* m = recovery_monitor::active())
+            if (alive) m->record(node.current_time(), perturbation, {{GCF, Datta, GCF__filtered, Datta__filtered}});
+        if (ensemble != nullptr)
+            ensemble->record(replica, node.current_time(), uid, {{GCF, Datta, GCF__filtered, Datta__filtered}}, perturbation, alive);
+    }
+    {
+        phase_timer timer(phase::tracing);
+        trace_writer* w = trace_writer::active();
+        snapshot_buffer* b = snapshot_buffer::active();
+        if (w != nullptr or b != nullptr) {
+            trace_state s;
+            s.x = trace_format::quantise(node.position()[0]);
+            s.y = trace_format::quantise(node.position()[1]);
+            s.gcf = GCF__filtered;
+            s.datta = Datta__filtered;
+            s.shape = uint8_t(node.storage(tags::node_shape{}));
+            s.size = trace_format::quantise(node.storage(tags::node_size{}));
+            s.alive = alive;
+            if (w != nullptr) w->record(node.current_time(), node.uid, s);
+            if (b != nullptr) b->record(node.current_time(), node.uid, s);
+        }
+    }
 }
 
+//! @brief Replays the active trace (or the latest snapshot of a live simulation), without computing the election algorithms.
+struct replay {
+    template <typename node_t>
+    void operator()(node_t& node, times_t) {
+        trace_state s;
+        if (snapshot_buffer* b = snapshot_buffer::active()) s = b->state(node.uid, node.current_time());
+        else {
+            trace_player& player = *trace_player::active();
+            s = player.state(node.uid, player.time(node.current_time()));
+        }
+        // reaches the recorded position at the next round
+        node.velocity() = make_vec(trace_format::real(s.x), trace_format::real(s.y)) - node.position();
+        node.storage(tags::node_size{}) = s.alive ? trace_format::real(s.size) : 0;
+        node.storage(tags::node_shape{}) = shape(s.shape);
+        node.storage(tags::gcf_color{}) = uid2col(s.gcf);
+        node.storage(tags::datta_color{}) = uid2col(s.datta);
+    }
+};
+
 
 }
 
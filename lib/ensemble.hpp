@@ -0,0 +1,208 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file ensemble.hpp
+ * @brief Ensembles of independent replicas of a simulation hosted by a single network.
+ *
+ * A network hosting `k` replicas of `n` devices spawns `k*n` devices, where device `uid` belongs to
+ * replica `uid / n` with local identifier `uid % n`. Every replica lives in its own area, shifted
+ * vertically so that no device is connected with devices of other replicas, and draws its random
+ * values keyed by its own seed. The outputs of every replica are sampled separately by the
+ * `ensemble_monitor`, as the aggregators of the network merge all replicas.
+ */
+
+#ifndef FCPP_ENSEMBLE_H_
+#define FCPP_ENSEMBLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "lib/fcpp.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Monitor of the replicas of an ensemble, sampling the outputs of each replica once per period.
+ *
+ * Every row holds the time followed by the distinct leaders, the correct nodes and the spurious
+ * nodes of every algorithm (as the columns of `aggregator_t`), over the nodes present in the replica
+ * before the rounds at that time. Nodes are present from the start until the round terminating them,
+ * and before their first round hold the defaults of the node storage (leader zero, neither correct nor
+ * spurious), as the nodes of a synchronous network spawned at time zero.
+ */
+class ensemble_monitor {
+  public:
+    //! @brief number of algorithms monitored
+    static constexpr size_t algorithms = 4;
+
+    //! @brief vertical distance between the areas of consecutive replicas (areas are 2 high, the connection radius is 1)
+    static constexpr double spacing = 4;
+
+    //! @brief constructor given the seeds of the replicas, their number of devices, and the end and period of sampling
+    ensemble_monitor(std::vector<uint32_t> seeds, size_t devices, double end, double period = 1) : m_seeds(seeds), m_replicas(seeds.size()), m_end(end), m_period(period) {
+        for (replica& r : m_replicas) r.nodes.resize(devices);
+    }
+
+    //! @brief the monitor of the ensemble run by the current thread (if any)
+    static ensemble_monitor*& active() {
+        thread_local ensemble_monitor* m = nullptr;
+        return m;
+    }
+
+    //! @brief number of replicas
+    size_t replicas() const {
+        return m_replicas.size();
+    }
+
+    //! @brief the seed of a replica
+    uint32_t seed(size_t r) const {
+        return m_seeds[r];
+    }
+
+    //! @brief records a round of a node of a replica (given its local identifier and the local leaders)
+    void record(size_t r, double t, size_t uid, std::array<device_t, algorithms> const& leaders, bool perturbation, bool alive) {
+        if (r >= m_replicas.size() or uid >= m_replicas[r].nodes.size()) return;
+        replica& p = m_replicas[r];
+        sample(p, t);
+        node_state& s = p.nodes[uid];
+        s.leaders = leaders;
+        for (size_t a = 0; a < algorithms; ++a) {
+            s.correct[a] = leaders[a] == perturbation;
+            s.spurious[a] = leaders[a] > perturbation;
+        }
+        s.present = alive;
+    }
+
+    //! @brief samples the rows left, at the end of the simulation
+    void finish() {
+        for (replica& p : m_replicas) sample(p, m_end);
+    }
+
+    //! @brief the rows sampled for a replica
+    std::vector<std::vector<double>> const& rows(size_t r) const {
+        return m_replicas[r].rows;
+    }
+
+  private:
+    //! @brief the latest state of a node (starting from the defaults of the node storage)
+    struct node_state {
+        //! @brief the leaders elected by every algorithm
+        std::array<device_t, algorithms> leaders{};
+        //! @brief whether the leaders are correct
+        std::array<int, algorithms> correct{};
+        //! @brief whether the leaders are spurious
+        std::array<int, algorithms> spurious{};
+        //! @brief whether the node is still in the network
+        bool present = true;
+    };
+
+    //! @brief the nodes and the rows of a replica
+    struct replica {
+        //! @brief the states of nodes
+        std::vector<node_state> nodes;
+        //! @brief the rows sampled so far
+        std::vector<std::vector<double>> rows;
+        //! @brief the time of the next row
+        double next = 0;
+    };
+
+    //! @brief samples the rows of a replica up to a given time
+    void sample(replica& p, double t) {
+        for (; p.next <= t and p.next <= m_end; p.next += m_period) {
+            std::vector<double> row(1 + 3 * algorithms, 0);
+            row[0] = p.next;
+            for (size_t a = 0; a < algorithms; ++a) {
+                std::vector<device_t> elected;
+                for (node_state const& s : p.nodes) if (s.present) {
+                    elected.push_back(s.leaders[a]);
+                    row[1 + algorithms + a] += s.correct[a];
+                    row[1 + 2 * algorithms + a] += s.spurious[a];
+                }
+                std::sort(elected.begin(), elected.end());
+                row[1 + a] = std::unique(elected.begin(), elected.end()) - elected.begin();
+            }
+            p.rows.push_back(std::move(row));
+        }
+    }
+
+    //! @brief the seeds of the replicas
+    std::vector<uint32_t> m_seeds;
+    //! @brief the replicas
+    std::vector<replica> m_replicas;
+    //! @brief the end and period of sampling
+    double m_end, m_period;
+};
+
+
+//! @brief Number of devices spawned by a network: the devices given by the tag `n` for every replica of the active ensemble (or for one).
+template <typename n>
+class replica_devices {
+  public:
+    //! @brief the type of the values
+    using type = size_t;
+
+    //! @brief constructor given a generator
+    template <typename G>
+    replica_devices(G&&) {}
+
+    //! @brief constructor given a generator and the initialisation values
+    template <typename G, typename T>
+    replica_devices(G&&, T const& t) : m_devices(common::get<n>(t)) {
+        if (ensemble_monitor* m = ensemble_monitor::active()) m_devices *= m->replicas();
+    }
+
+    //! @brief the number of devices
+    template <typename G>
+    type operator()(G&&) const {
+        return m_devices;
+    }
+
+  private:
+    //! @brief the number of devices
+    size_t m_devices = 0;
+};
+
+
+//! @brief Distribution of positions `D`, shifting the n-th value drawn in the area of the replica of device n (with replicas of the number of devices given by the tag `n`).
+template <typename D, typename n>
+class replica_start {
+  public:
+    //! @brief the type of the values
+    using type = typename D::type;
+
+    //! @brief constructor given a generator
+    template <typename G>
+    replica_start(G&& g) : m_d(g) {}
+
+    //! @brief constructor given a generator and the initialisation values
+    template <typename G, typename T>
+    replica_start(G&& g, T const& t) : m_d(g, t), m_devices(common::get<n>(t)) {}
+
+    //! @brief draws the position of the next device spawned
+    template <typename G>
+    type operator()(G&& g) {
+        type x = m_d(g);
+        if (m_devices > 0) x[1] += (m_count++ / m_devices) * ensemble_monitor::spacing;
+        return x;
+    }
+
+  private:
+    //! @brief the distribution of positions in the area of a replica
+    D m_d;
+    //! @brief the number of devices of every replica (zero if unknown)
+    size_t m_devices = 0;
+    //! @brief the number of devices spawned
+    size_t m_count = 0;
+};
+
+
+}
+
+#endif // FCPP_ENSEMBLE_H_
@@ -24,6 +24,18 @@ constexpr double SS    = 1.414213562373095;
 //! @brief √2 exact.
 const     sq2    S(0,1);
 
+//! @brief Certificate bounding the competitiveness of a function for all x.
+struct certificate {
+    //! @brief whether the bound has been proven
+    bool valid;
+    //! @brief competitiveness bound
+    frac bound;
+    //! @brief maximum competitiveness of the values checked explicitly
+    frac found;
+    //! @brief values below are checked explicitly, values above are bounded analytically
+    int threshold;
+};
+
 //! @brief Function guiding leader election.
 class func {
   public:
@@ -97,6 +109,43 @@ class func {
     size_t size() const {
         return xs.back()+1;
     }
+
+    /**
+     * @brief certifies that recovery(x) <= K ideal(x) for all x (K is the competitiveness)
+     *
+     * Beyond a threshold t, inv(x) <= (√2-1)x + k, so that convergence(x) <= Kx + B holds by induction
+     * (B being its maximum before t), and recovery(x) <= (K+1+√2)x + B + alpha + 1 <= K ideal(x) beyond
+     * a second threshold, before which values are checked explicitly. Conditions are checked in exact
+     * arithmetic at the thresholds, and hold beyond them since they are linear in x. Rounding in dir and
+     * inv is accounted for by a unit each.
+     */
+    certificate certify() const {
+        certificate c{false, K, 1, 0};
+        long long p = K.numerator(), q = K.denominator();
+        int n = size();
+        // the tail bounds require K > 1+√2
+        if (sq2(p-q, -q) <= 0) return c;
+        // inv(x) <= max(n, (√2-1)(x-alpha) + 2) beyond ys.back()
+        sq2 k = 2 - (S-1)*alpha;
+        auto closes = [&](long long t) {
+            return (S-1)*t + k >= n and (S-1)*t + k <= t-1 and (p+q)*((S-1)*t + k) + q*t + q <= p*t;
+        };
+        long long t = std::max({(long long)cs.size(), (long long)ys.back()+1, (long long)n+1,
+                                (long long)(((double(K)+1)*double(k) + 1) / ((2-SS)*(double(K)-1-SS))) + 1});
+        for (; not closes(t); t *= 2) if (t > (1<<24)) return c;
+        // maximum of q convergence(x) - p x before t
+        long long bq = q*convergence(0);
+        for (int x=1; x<t; ++x) bq = std::max(bq, q*convergence(x) - p*x);
+        auto ends = [&](long long m) {
+            return bq + q*alpha + q - p <= (p-q - q*S) * m;
+        };
+        long long m = std::max(t, (long long)((bq + q*double(alpha) + q - p) / (p-q - q*SS)) + 1);
+        for (; not ends(m); m *= 2) if (m > (1<<24)) return c;
+        for (int x=0; x<m; ++x) c.found = std::max(c.found, frac(recovery(x), ideal(x)));
+        c.threshold = m;
+        c.valid = c.found <= K;
+        return c;
+    }
     
   private:
     //! @brief inserts a pair for which func(x) = y (possibly updating backwards to ensure monotonicity)
@@ -171,4 +220,55 @@ std::ostream& operator<<(std::ostream& o, const func& g) {
 }
 
 
+//! @brief printing as a header with a compile-time table of the function
+void print_header(std::ostream& o, const func& g) {
+    std::vector<int> xs, ys;
+    for (int x=0; x<(int)g.size(); ++x)
+        if (x == 0 or g.dir(x) != g.dir(x-1)) {
+            xs.push_back(x);
+            ys.push_back(g.dir(x));
+        }
+    auto print = [&](std::vector<int> const& v) {
+        for (size_t i=0; i<v.size(); ++i)
+            o << v[i] << (i+1 == v.size() ? "\n" : i%16 == 15 ? ",\n    " : ", ");
+    };
+    o << "// Generated by run/parameter.cpp, do not edit.\n\n";
+    o << "/**\n * @file g_function.hpp\n * @brief Compile-time table of the function guiding leader election, with competitiveness " << g.competitiveness() << ".\n */\n\n";
+    o << "#ifndef CPP_G_FUNCTION_H_\n#define CPP_G_FUNCTION_H_\n\n\n";
+    o << "/**\n * @brief Namespace containing all the objects in the FCPP library.\n */\nnamespace fcpp {\n\n\n";
+    o << "//! @brief Namespace containing the libraries of coordination routines.\nnamespace coordination {\n\n\n";
+    o << "//! @brief Breakpoints of the function: g(x) = g_ys[i] for g_xs[i] <= x < g_xs[i+1].\n";
+    o << "constexpr int g_xs[] = {\n    ";
+    print(xs);
+    o << "};\n\n//! @brief Values of the function at breakpoints.\nconstexpr int g_ys[] = {\n    ";
+    print(ys);
+    o << "};\n\n//! @brief Number of values defined by the table.\nconstexpr int g_size = " << g.size() << ";\n\n";
+    o << "//! @brief Offset a + √2 b of the function beyond the table, where g(x) = (1+√2) x + a + √2 b.\n";
+    o << "constexpr long long g_alpha_a = " << g.offset().integral() << ", g_alpha_b = " << g.offset().irrational() << ";\n\n\n";
+    o << R"(//! @brief Function guiding leader election.
+struct g_function {
+    //! @brief direct application of function (matching func::dir)
+    constexpr int operator()(int x) const {
+        if (x >= g_size) return double(x + g_alpha_a) + double(x + g_alpha_b) * 1.414213562373095;
+        int lo = 0, hi = sizeof(g_xs) / sizeof(int);
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (g_xs[mid] <= x) lo = mid;
+            else hi = mid;
+        }
+        return g_ys[lo];
+    }
+};
+
+
+}
+
+
+}
+
+#endif // CPP_G_FUNCTION_H_
+)";
+}
+
+
 #endif // CPP_FUNC_H_
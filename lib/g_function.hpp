@@ -0,0 +1,96 @@
+// Generated by run/parameter.cpp, do not edit.
+
+/**
+ * @file g_function.hpp
+ * @brief Compile-time table of the function guiding leader election, with competitiveness 1992/797.
+ */
+
+#ifndef CPP_G_FUNCTION_H_
+#define CPP_G_FUNCTION_H_
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Namespace containing the libraries of coordination routines.
+namespace coordination {
+
+
+//! @brief Breakpoints of the function: g(x) = g_ys[i] for g_xs[i] <= x < g_xs[i+1].
+constexpr int g_xs[] = {
+    0, 1, 2, 3, 4, 6, 7, 8, 9, 10, 11, 14, 15, 16, 17, 18,
+    19, 20, 21, 22, 23, 24, 25, 31, 32, 33, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 49, 50, 51, 52, 53, 54, 55, 56, 57,
+    58, 59, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 82, 83, 84, 86,
+    87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 100, 101, 102, 103,
+    104, 105, 106, 107, 108, 109, 110, 111, 112, 114, 115, 116, 117, 118, 119, 120,
+    121, 122, 123, 124, 125, 128, 129, 130, 132, 133, 134, 135, 136, 137, 138, 139,
+    140, 141, 142, 163, 164, 165, 166, 167, 168, 169, 170, 171, 172, 173, 175, 176,
+    177, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187, 189, 190, 191, 192, 193,
+    194, 195, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 211, 212, 213, 215,
+    216, 217, 218, 219, 220, 221, 222, 223, 224, 225, 226, 227, 229, 230, 231, 232,
+    233, 234, 235, 236, 237, 238, 239, 240, 241, 243, 244, 245, 246, 247, 248, 249,
+    250, 251, 252, 253, 254, 257, 258, 259, 261, 262, 263, 264, 265, 266, 267, 268,
+    269, 270, 271, 272, 273, 275, 276, 277, 278, 279, 280, 281, 282, 283, 284, 285,
+    286, 287, 289, 290, 291, 292, 293, 294, 295, 296, 297, 298, 299, 300, 303, 304,
+    305, 307, 308, 309, 310, 311, 312, 313, 314, 315, 316, 317, 318, 319, 321, 322,
+    323, 324, 325, 326, 327, 328, 329, 330, 331, 332, 333, 335, 336, 337, 338, 339,
+    340, 341, 345, 346, 347, 348, 349, 350, 351, 352, 353, 354, 394, 395, 396, 397,
+    398
+};
+
+//! @brief Values of the function at breakpoints.
+constexpr int g_ys[] = {
+    1, 4, 5, 9, 12, 14, 18, 22, 26, 28, 29, 33, 35, 39, 43, 47,
+    49, 53, 57, 61, 63, 67, 68, 72, 76, 80, 84, 86, 90, 94, 98, 100,
+    104, 108, 112, 114, 118, 122, 126, 130, 132, 136, 140, 144, 146, 150, 154, 158,
+    160, 161, 165, 169, 173, 175, 179, 183, 187, 189, 193, 197, 201, 205, 209, 213,
+    215, 219, 223, 227, 229, 233, 237, 241, 243, 247, 251, 255, 259, 261, 265, 269,
+    273, 275, 279, 283, 287, 289, 293, 297, 301, 305, 307, 311, 315, 319, 321, 325,
+    329, 333, 335, 339, 343, 347, 351, 355, 359, 361, 365, 369, 373, 375, 379, 383,
+    387, 389, 392, 396, 400, 404, 406, 410, 414, 418, 420, 424, 428, 432, 436, 438,
+    442, 446, 450, 452, 456, 460, 464, 466, 470, 474, 478, 482, 484, 488, 492, 496,
+    498, 500, 504, 508, 512, 514, 518, 522, 526, 528, 532, 536, 540, 544, 548, 552,
+    554, 558, 562, 566, 568, 572, 576, 580, 582, 586, 590, 594, 598, 600, 604, 608,
+    612, 614, 618, 622, 626, 628, 632, 636, 640, 644, 646, 650, 654, 658, 660, 664,
+    668, 672, 674, 678, 682, 686, 690, 694, 698, 700, 704, 708, 712, 714, 718, 722,
+    726, 728, 732, 736, 740, 744, 746, 750, 754, 758, 760, 764, 768, 772, 774, 778,
+    782, 786, 790, 792, 796, 800, 804, 806, 810, 814, 818, 820, 824, 828, 832, 836,
+    840, 844, 846, 850, 854, 858, 860, 864, 868, 872, 874, 878, 882, 886, 890, 892,
+    896, 900, 904, 906, 910, 914, 918, 920, 924, 928, 932, 936, 938, 942, 946, 950,
+    952, 954, 958, 962, 966, 968, 972, 976, 980, 982, 986, 989, 993, 997, 1001, 1003,
+    1007
+};
+
+//! @brief Number of values defined by the table.
+constexpr int g_size = 399;
+
+//! @brief Offset a + √2 b of the function beyond the table, where g(x) = (1+√2) x + a + √2 b.
+constexpr long long g_alpha_a = 237, g_alpha_b = -164;
+
+
+//! @brief Function guiding leader election.
+struct g_function {
+    //! @brief direct application of function (matching func::dir)
+    constexpr int operator()(int x) const {
+        if (x >= g_size) return double(x + g_alpha_a) + double(x + g_alpha_b) * 1.414213562373095;
+        int lo = 0, hi = sizeof(g_xs) / sizeof(int);
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (g_xs[mid] <= x) lo = mid;
+            else hi = mid;
+        }
+        return g_ys[lo];
+    }
+};
+
+
+}
+
+
+}
+
+#endif // CPP_G_FUNCTION_H_
@@ -0,0 +1,130 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file live_snapshot.hpp
+ * @brief Snapshots of a simulation running in a thread, published to a renderer running in another.
+ */
+
+#ifndef FCPP_LIVE_SNAPSHOT_H_
+#define FCPP_LIVE_SNAPSHOT_H_
+
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "lib/trace.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Double-buffered snapshots of the states of nodes, written by a simulation and read by a renderer.
+ *
+ * The simulation thread updates a working copy of the states, which is published once per period of
+ * simulated time into the back buffer. The renderer thread reads the front buffer, swapping it with
+ * the back buffer whenever its time advances and a newer snapshot is available, so that it always
+ * draws the latest complete snapshot.
+ *
+ * The simulation is throttled by the clock of the renderer: a snapshot is published only when the
+ * renderer has read up to a given lead of simulated time before it, so that pausing the renderer or
+ * changing its speed pauses the simulation or changes its speed accordingly. Once the renderer stops,
+ * the simulation runs to its end unthrottled.
+ */
+class snapshot_buffer {
+  public:
+    //! @brief constructor given the number of nodes, the period of simulated time between snapshots, and the lead of the simulation on the renderer (twice the period if negative)
+    snapshot_buffer(size_t nodes, double period = 1, double lead = -1) : m_working(nodes), m_back(nodes), m_front(nodes), m_period(period), m_lead(lead < 0 ? 2 * period : lead), m_next(period) {}
+
+    //! @brief the buffer currently connecting a simulation with a renderer (if any)
+    static snapshot_buffer*& active() {
+        static snapshot_buffer* b = nullptr;
+        return b;
+    }
+
+    //! @brief records the state of a node at a given time (publishing the snapshot of the periods before it first)
+    void record(double t, uint32_t uid, trace_state const& s) {
+        if (t >= m_next) {
+            publish(m_next);
+            m_next = (std::floor(t / m_period) + 1) * m_period;
+        }
+        if (uid < m_working.size()) m_working[uid] = s;
+    }
+
+    //! @brief publishes the last snapshot, at the end of the simulation
+    void finish(double t) {
+        publish(t);
+    }
+
+    //! @brief stops throttling the simulation, when the renderer exits
+    void stop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+        m_advanced.notify_all();
+    }
+
+    //! @brief the state of a node in the latest complete snapshot (looking for a newer one if the renderer time changed)
+    trace_state const& state(uint32_t uid, double t) {
+        if (t != m_last_read) {
+            m_last_read = t;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_read_time = t;
+            m_advanced.notify_all();
+            if (m_fresh) {
+                m_front.swap(m_back);
+                m_front_time = m_back_time;
+                m_fresh = false;
+            }
+        }
+        return uid < m_front.size() ? m_front[uid] : m_none;
+    }
+
+    //! @brief the simulated time of the snapshot being read
+    double time() const {
+        return m_front_time;
+    }
+
+  private:
+    //! @brief copies the working states into the back buffer (waiting for the renderer to be within the lead)
+    void publish(double t) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_advanced.wait(lock, [&](){ return m_stopped or t <= m_read_time + m_lead; });
+        m_back = m_working;
+        m_back_time = t;
+        m_fresh = true;
+    }
+
+    //! @brief the states updated by the simulation
+    std::vector<trace_state> m_working;
+    //! @brief the latest snapshot published, and the snapshot being read
+    std::vector<trace_state> m_back, m_front;
+    //! @brief period of simulated time between snapshots
+    double m_period;
+    //! @brief simulated time the simulation may be ahead of the renderer
+    double m_lead;
+    //! @brief time of the next snapshot
+    double m_next;
+    //! @brief simulated time of the back and front snapshots
+    double m_back_time = 0, m_front_time = 0;
+    //! @brief renderer time of the last read (as seen by the renderer, and by the simulation)
+    double m_last_read = -1, m_read_time = 0;
+    //! @brief whether the renderer stopped
+    bool m_stopped = false;
+    //! @brief whether the back snapshot is newer than the front one
+    bool m_fresh = false;
+    //! @brief mutex regulating swaps and publications
+    std::mutex m_mutex;
+    //! @brief notifies the simulation of advances of the renderer
+    std::condition_variable m_advanced;
+    //! @brief the state of nodes not in the snapshots
+    trace_state m_none;
+};
+
+
+}
+
+#endif // FCPP_LIVE_SNAPSHOT_H_
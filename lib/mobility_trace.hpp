@@ -0,0 +1,256 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file mobility_trace.hpp
+ * @brief Memory-mapped traces of device positions, driving the movement of devices.
+ */
+
+#ifndef FCPP_MOBILITY_TRACE_H_
+#define FCPP_MOBILITY_TRACE_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Common definitions of mobility trace readers and writers.
+ *
+ * A trace is a header followed by samples taken at regular times, each sample being the positions
+ * of all devices as pairs of floats, so that the position of a device at a time is found in constant time.
+ */
+struct mobility_format {
+    //! @brief magic number opening trace files
+    static constexpr uint32_t magic = 0x54424f4d; // "MOBT"
+
+    //! @brief a position
+    using position_type = std::array<float, 2>;
+
+    //! @brief header of a trace
+    struct header {
+        //! @brief magic number
+        uint32_t magic;
+        //! @brief number of devices
+        uint32_t devices;
+        //! @brief number of samples
+        uint64_t samples;
+        //! @brief time of the first sample
+        double start;
+        //! @brief time between samples
+        double step;
+        //! @brief side of the area
+        double side;
+    };
+};
+
+
+//! @brief Writer of a mobility trace, appending one sample at a time.
+class mobility_writer : public mobility_format {
+  public:
+    //! @brief constructor given the path, the number of devices, the timing of samples and the area side
+    mobility_writer(std::string const& path, uint32_t devices, double start, double step, double side) : m_out(path, std::ios::binary), m_header{magic, devices, 0, start, step, side} {
+        m_out.write(reinterpret_cast<char const*>(&m_header), sizeof(header));
+    }
+
+    //! @brief completes the trace
+    ~mobility_writer() {
+        close();
+    }
+
+    //! @brief appends a sample (with the position of every device)
+    void sample(std::vector<position_type> const& v) {
+        std::vector<position_type> s(v);
+        s.resize(m_header.devices, position_type{{0, 0}});
+        m_out.write(reinterpret_cast<char const*>(s.data()), s.size() * sizeof(position_type));
+        ++m_header.samples;
+    }
+
+    //! @brief writes the final number of samples and closes the trace
+    void close() {
+        if (not m_out.is_open()) return;
+        m_out.seekp(0);
+        m_out.write(reinterpret_cast<char const*>(&m_header), sizeof(header));
+        m_out.close();
+    }
+
+  private:
+    //! @brief the output file
+    std::ofstream m_out;
+    //! @brief the header
+    header m_header;
+};
+
+
+/**
+ * @brief Reader of a mobility trace, interpolating positions between samples.
+ *
+ * The file is memory-mapped, so that only the pages around the times being simulated are loaded
+ * (in the page cache, shared by concurrent runs), and opening does not depend on the trace size.
+ * On platforms without `mmap`, samples are read from file when needed.
+ */
+class mobility_trace : public mobility_format {
+  public:
+    //! @brief constructor given the path
+    mobility_trace(std::string const& path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 and size_t(st.st_size) >= sizeof(header)) {
+            m_size = st.st_size;
+            void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) m_data = static_cast<char const*>(p);
+        }
+        ::close(fd);
+        if (m_data == nullptr) return;
+        m_header = *reinterpret_cast<header const*>(m_data);
+#else
+        m_in.open(path, std::ios::binary);
+        m_in.read(reinterpret_cast<char*>(&m_header), sizeof(header));
+        m_in.seekg(0, std::ios::end);
+        m_size = m_in.tellg();
+#endif
+        m_ok = m_header.magic == magic and m_header.step > 0 and m_header.samples > 0 and m_size >= sizeof(header) + m_header.samples * m_header.devices * sizeof(position_type);
+    }
+
+    //! @brief unmaps the trace
+    ~mobility_trace() {
+#ifndef _WIN32
+        if (m_data != nullptr) ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    //! @brief whether the trace has been read correctly
+    bool good() const {
+        return m_ok;
+    }
+
+    //! @brief the header of the trace
+    header const& info() const {
+        return m_header;
+    }
+
+    //! @brief the trace currently driving devices (if any)
+    static mobility_trace*& active() {
+        static mobility_trace* m = nullptr;
+        return m;
+    }
+
+    //! @brief whether the trace has positions for a device
+    bool has(uint32_t uid) const {
+        return m_ok and uid < m_header.devices;
+    }
+
+    //! @brief whether the trace has been recorded in an area with a given side
+    bool fits(double side) const {
+        return std::abs(m_header.side - side) < 1e-6;
+    }
+
+    //! @brief the position of a device at a given time (linearly interpolated, and held before the first and after the last sample)
+    std::array<double, 2> position(uint32_t uid, double t) {
+        double k = (t - m_header.start) / m_header.step;
+        k = std::min(std::max(k, 0.0), double(m_header.samples - 1));
+        uint64_t i = std::min(uint64_t(k), m_header.samples - 1);
+        uint64_t j = std::min(i + 1, m_header.samples - 1);
+        double f = k - i;
+        position_type a = sample(i, uid), b = sample(j, uid);
+        return {{a[0] + f * (b[0] - a[0]), a[1] + f * (b[1] - a[1])}};
+    }
+
+  private:
+    //! @brief the position of a device in a sample
+    position_type sample(uint64_t i, uint32_t uid) {
+        size_t offset = sizeof(header) + (i * m_header.devices + uid) * sizeof(position_type);
+        position_type p;
+#ifndef _WIN32
+        std::copy(m_data + offset, m_data + offset + sizeof(position_type), reinterpret_cast<char*>(&p));
+#else
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_in.seekg(offset);
+        m_in.read(reinterpret_cast<char*>(&p), sizeof(position_type));
+#endif
+        return p;
+    }
+
+    //! @brief the header
+    header m_header{0, 0, 0, 0, 0, 0};
+    //! @brief the size of the file
+    size_t m_size = 0;
+    //! @brief whether the trace has been read correctly
+    bool m_ok = false;
+#ifndef _WIN32
+    //! @brief the mapped file
+    char const* m_data = nullptr;
+#else
+    //! @brief the input file
+    std::ifstream m_in;
+    //! @brief mutex regulating concurrent reads
+    std::mutex m_mutex;
+#endif
+};
+
+
+/**
+ * @brief Distribution of the initial positions of devices: their first position in the active mobility
+ * trace (if any), or the value drawn by the distribution `D` otherwise.
+ *
+ * Devices are spawned in order of identifier, so that the n-th value drawn is the position of device n.
+ * The value of `D` is drawn anyways, so that the random sequence of the network does not depend on the trace.
+ */
+template <typename D>
+class mobility_start {
+  public:
+    //! @brief the type of the values
+    using type = typename D::type;
+
+    //! @brief constructor given a generator
+    template <typename G>
+    mobility_start(G&& g) : m_d(g) {}
+
+    //! @brief constructor given a generator and the initialisation values
+    template <typename G, typename T>
+    mobility_start(G&& g, T const& t) : m_d(g, t) {}
+
+    //! @brief draws the position of the next device spawned
+    template <typename G>
+    type operator()(G&& g) {
+        type x = m_d(g);
+        uint32_t uid = m_count++;
+        mobility_trace* m = mobility_trace::active();
+        if (m != nullptr and m->has(uid)) {
+            std::array<double, 2> p = m->position(uid, m->info().start);
+            x[0] = p[0];
+            x[1] = p[1];
+        }
+        return x;
+    }
+
+  private:
+    //! @brief the distribution used without a trace
+    D m_d;
+    //! @brief the number of devices spawned
+    uint32_t m_count = 0;
+};
+
+
+}
+
+#endif // FCPP_MOBILITY_TRACE_H_
@@ -0,0 +1,70 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file neighbour_histogram.hpp
+ * @brief Histogram of the neighbourhood sizes observed in node rounds.
+ */
+
+#ifndef FCPP_NEIGHBOUR_HISTOGRAM_H_
+#define FCPP_NEIGHBOUR_HISTOGRAM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Histogram of non-negative integer values, which can be filled concurrently.
+class histogram {
+  public:
+    //! @brief constructor given the number of buckets (the last one collecting all larger values)
+    histogram(size_t buckets) : m_counts(buckets) {}
+
+    //! @brief adds a value
+    void insert(int x) {
+        size_t i = x < 0 ? 0 : std::min(size_t(x), m_counts.size()-1);
+        m_counts[i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! @brief the counts of the buckets, dropping empty trailing ones
+    std::vector<uint64_t> counts() const {
+        std::vector<uint64_t> v;
+        for (auto const& c : m_counts) v.push_back(c.load(std::memory_order_relaxed));
+        while (not v.empty() and v.back() == 0) v.pop_back();
+        return v;
+    }
+
+    //! @brief prints the histogram as a plot in the format understood by `plot.asy` (as relative frequencies)
+    void plot(std::ostream& o, std::string const& path, std::string const& title, std::string const& xlabel, std::string const& column) const {
+        std::vector<uint64_t> v = counts();
+        uint64_t total = 0;
+        for (uint64_t c : v) total += c;
+        o << "plot.put(plot.plot(name+\"-" << path << "\", \"" << title << "\", \"" << xlabel << "\", \"freq\", new string[] {\"" << column << "\"}, new pair[][] {{";
+        for (size_t i=0; i<v.size(); ++i) o << (i ? ", " : "") << "(" << i << ", " << double(v[i]) / total << ")";
+        o << "}}));\n\n";
+    }
+
+  private:
+    //! @brief the counts of the buckets
+    std::vector<std::atomic<uint64_t>> m_counts;
+};
+
+
+//! @brief Histogram of the neighbourhood sizes observed in node rounds.
+inline histogram& neighbour_histogram() {
+    static histogram h(256);
+    return h;
+}
+
+
+}
+
+#endif // FCPP_NEIGHBOUR_HISTOGRAM_H_
@@ -0,0 +1,250 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file phase_timers.hpp
+ * @brief Compile-time switchable timers and counters of the phases of simulation runs.
+ *
+ * If `ELECTION_PHASE_TIMERS` is defined, the time spent in scopes marked with `phase_timer` is
+ * accumulated per thread (that is, per run in batch executions) and in total, otherwise timers are
+ * empty objects with no cost. The connector, round schedule and aggregators of the simulator are
+ * timed by passing them through `timed_connector`, `timed_sequence` and `timed_aggregator`.
+ *
+ * Only the time of the threads executing runs is attributed to them: the worker threads of parallel
+ * runs (as the `--large` run of the batch target) accumulate totals that are never reported, so that
+ * the phases of the rounds they execute are counted in the simulator remainder of the run.
+ */
+
+#ifndef FCPP_PHASE_TIMERS_H_
+#define FCPP_PHASE_TIMERS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Phases of a simulation run.
+enum class phase { election, movement, instrumentation, neighbourhood, monitoring, tracing, plotting, logging, connection, scheduling, aggregation };
+
+
+//! @brief Totals of the time spent and scopes entered in each phase, per thread and in total.
+struct phase_timers {
+    //! @brief clock type
+    using clock_t = std::chrono::steady_clock;
+
+    //! @brief number of phases
+    static constexpr size_t phases = 11;
+
+    //! @brief name of a phase
+    static char const* name(size_t i) {
+        static char const* names[phases] = {"election", "movement", "instrumentation", "neighbourhood", "monitoring", "tracing", "plotting", "logging", "connection", "scheduling", "aggregation"};
+        return names[i];
+    }
+
+    //! @brief totals of a thread
+    struct totals {
+        //! @brief nanoseconds spent in each phase
+        std::array<uint64_t, phases> nanoseconds{};
+        //! @brief scopes entered in each phase
+        std::array<uint64_t, phases> counts{};
+    };
+
+    //! @brief totals of the current thread since the last report
+    static totals& local() {
+        thread_local totals t;
+        return t;
+    }
+
+    //! @brief nanoseconds spent in each phase by all threads
+    static std::array<std::atomic<uint64_t>, phases>& global_nanoseconds() {
+        static std::array<std::atomic<uint64_t>, phases> a{};
+        return a;
+    }
+
+    //! @brief scopes entered in each phase by all threads
+    static std::array<std::atomic<uint64_t>, phases>& global_counts() {
+        static std::array<std::atomic<uint64_t>, phases> a{};
+        return a;
+    }
+
+    //! @brief nanoseconds of wall-clock time of all the runs reported
+    static std::atomic<uint64_t>& global_runs() {
+        static std::atomic<uint64_t> n{0};
+        return n;
+    }
+
+    //! @brief whether timers are enabled
+    static constexpr bool enabled() {
+#ifdef ELECTION_PHASE_TIMERS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    //! @brief takes the totals of the current thread for a run of a given wall-clock time, moving them to the global totals
+    static totals take(double seconds) {
+        totals t = local();
+        for (size_t i = 0; i < phases; ++i) {
+            global_nanoseconds()[i] += t.nanoseconds[i];
+            global_counts()[i] += t.counts[i];
+        }
+        global_runs() += uint64_t(seconds * 1e9);
+        local() = totals{};
+        return t;
+    }
+
+    /**
+     * @brief The totals of a run as a comment line.
+     *
+     * @param t The totals of the run.
+     * @param seconds The wall-clock time of the run, whose remainder is reported as the simulator phase
+     *                (the parts of FCPP not wrapped by timers, as its event queue and node maps).
+     */
+    static std::string comment(totals const& t, double seconds) {
+        std::stringstream ss;
+        ss << "# phase times:";
+        print(ss, t.nanoseconds, t.counts, seconds);
+        return ss.str();
+    }
+
+    //! @brief The totals of a run as JSON fields (seconds and counts of each phase, and the remainder of the wall-clock time).
+    static std::string json(totals const& t, double seconds) {
+        std::stringstream ss;
+        double rest = seconds;
+        for (size_t i = 0; i < phases; ++i) {
+            ss << "\"" << name(i) << "_seconds\": " << t.nanoseconds[i] * 1e-9 << ", \"" << name(i) << "_count\": " << t.counts[i] << ", ";
+            rest -= t.nanoseconds[i] * 1e-9;
+        }
+        ss << "\"simulator_seconds\": " << rest;
+        return ss.str();
+    }
+
+    //! @brief prints a summary of the global totals (with the remainder of the wall-clock time of the runs reported)
+    static void summary(std::ostream& o) {
+        if (not enabled()) return;
+        std::array<uint64_t, phases> ns, cs;
+        for (size_t i = 0; i < phases; ++i) {
+            ns[i] = global_nanoseconds()[i];
+            cs[i] = global_counts()[i];
+        }
+        o << "phase times:";
+        print(o, ns, cs, global_runs() * 1e-9);
+        o << std::endl;
+    }
+
+  private:
+    //! @brief prints the seconds and counts of each phase, and the remainder of the wall-clock time
+    static void print(std::ostream& o, std::array<uint64_t, phases> const& ns, std::array<uint64_t, phases> const& cs, double seconds) {
+        double rest = seconds;
+        o << std::fixed << std::setprecision(3);
+        for (size_t i = 0; i < phases; ++i) {
+            o << " " << name(i) << " " << ns[i] * 1e-9 << "s/" << cs[i];
+            rest -= ns[i] * 1e-9;
+        }
+        o << " simulator " << rest << "s" << std::defaultfloat << std::setprecision(6);
+    }
+};
+
+
+//! @brief Timer accumulating the time spent in its scope into a phase (if enabled).
+class phase_timer {
+  public:
+#ifdef ELECTION_PHASE_TIMERS
+    //! @brief constructor starting the timer
+    phase_timer(phase p) : m_phase(size_t(p)), m_start(phase_timers::clock_t::now()) {}
+
+    //! @brief destructor accumulating the time
+    ~phase_timer() {
+        phase_timers::totals& t = phase_timers::local();
+        t.nanoseconds[m_phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(phase_timers::clock_t::now() - m_start).count();
+        ++t.counts[m_phase];
+    }
+
+  private:
+    //! @brief the phase
+    size_t m_phase;
+    //! @brief the starting time
+    phase_timers::clock_t::time_point m_start;
+#else
+    //! @brief constructor (doing nothing)
+    phase_timer(phase) {}
+#endif
+};
+
+
+//! @brief Connector timing its connection checks in the connection phase (as the connector `C` otherwise).
+template <typename C>
+struct timed_connector : public C {
+    using C::C;
+
+    //! @brief checks whether two nodes are connected
+    template <typename G, typename... Ts>
+    bool operator()(G&& g, Ts const&... xs) const {
+        phase_timer timer(phase::connection);
+        return C::operator()(std::forward<G>(g), xs...);
+    }
+};
+
+//! @brief Sequence timing the generation of its events in the scheduling phase (as the sequence `S` otherwise).
+template <typename S>
+struct timed_sequence : public S {
+    using S::S;
+
+    //! @brief steps over the next event
+    template <typename G>
+    void step(G&& g) {
+        phase_timer timer(phase::scheduling);
+        S::step(std::forward<G>(g));
+    }
+
+    //! @brief returns the next event, stepping over it
+    template <typename G>
+    auto operator()(G&& g) {
+        phase_timer timer(phase::scheduling);
+        return S::operator()(std::forward<G>(g));
+    }
+};
+
+//! @brief Aggregator timing the updates of its values in the aggregation phase (as the aggregator `A` otherwise).
+template <typename A>
+struct timed_aggregator : public A {
+    using A::A;
+
+    //! @brief inserts a value
+    template <typename T>
+    void insert(T const& value) {
+        phase_timer timer(phase::aggregation);
+        A::insert(value);
+    }
+
+    //! @brief erases a value
+    template <typename T>
+    void erase(T const& value) {
+        phase_timer timer(phase::aggregation);
+        A::erase(value);
+    }
+
+    //! @brief combines with another aggregator
+    timed_aggregator& operator+=(timed_aggregator const& o) {
+        phase_timer timer(phase::aggregation);
+        A::operator+=(o);
+        return *this;
+    }
+};
+
+
+}
+
+#endif // FCPP_PHASE_TIMERS_H_
@@ -0,0 +1,111 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file philox.hpp
+ * @brief Implementation of the Philox4x32-10 counter-based random generator.
+ */
+
+#ifndef FCPP_PHILOX_H_
+#define FCPP_PHILOX_H_
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Philox4x32-10 counter-based generator (Salmon et al., SC 2011).
+ *
+ * Random blocks are a pure function of a 64-bit key and a 128-bit counter, so that any block
+ * can be regenerated in constant time, independently of the order in which blocks are requested.
+ */
+class philox {
+  public:
+    //! @brief type of the random words
+    using word_type = uint32_t;
+
+    //! @brief type of a random block
+    using block_type = std::array<word_type, 4>;
+
+    //! @brief constructor given the two words of the key
+    constexpr philox(word_type k0, word_type k1) : m_key{k0, k1} {}
+
+    //! @brief the random block for a given counter
+    block_type operator()(block_type ctr) const {
+        std::array<word_type, 2> key = m_key;
+        for (int r=0; r<10; ++r) {
+            if (r > 0) {
+                key[0] += 0x9E3779B9;
+                key[1] += 0xBB67AE85;
+            }
+            uint64_t p0 = uint64_t(0xD2511F53) * ctr[0];
+            uint64_t p1 = uint64_t(0xCD9E8D57) * ctr[2];
+            ctr = {
+                word_type(p1 >> 32) ^ ctr[1] ^ key[0], word_type(p1),
+                word_type(p0 >> 32) ^ ctr[3] ^ key[1], word_type(p0)
+            };
+        }
+        return ctr;
+    }
+
+  private:
+    //! @brief the key
+    std::array<word_type, 2> m_key;
+};
+
+
+/**
+ * @brief Uniform random real in [0,1) keyed by a seed and a device, for a given round and stream.
+ *
+ * Different streams allow for independent random values to be drawn in the same round.
+ */
+inline double counter_real(uint32_t seed, uint32_t uid, uint32_t round, uint32_t stream = 0) {
+    philox::block_type b = philox(seed, uid)({round, stream, 0, 0});
+    // 53 random bits from the first two words
+    uint64_t x = (uint64_t(b[0]) << 21) ^ (b[1] >> 11);
+    return x * (1.0 / (uint64_t(1) << 53));
+}
+
+
+//! @brief Shape parameter of a Weibull distribution with a given coefficient of variation (by bisection).
+inline double weibull_shape(double cv) {
+    double lo = 0.1, hi = 100;
+    for (int i=0; i<100; ++i) {
+        double k = (lo + hi) / 2;
+        double g1 = std::tgamma(1 + 1/k);
+        double c = std::sqrt(std::tgamma(1 + 2/k) / (g1 * g1) - 1);
+        // the coefficient of variation is decreasing in the shape
+        if (c > cv) lo = k;
+        else hi = k;
+    }
+    return (lo + hi) / 2;
+}
+
+/**
+ * @brief Random real with Weibull distribution given mean and standard deviation, keyed as `counter_real`.
+ *
+ * Matches the parametrisation of `distribution::weibull` in FCPP.
+ */
+inline double counter_weibull(double mean, double dev, uint32_t seed, uint32_t uid, uint32_t round, uint32_t stream = 0) {
+    if (dev <= 0) return mean;
+    // the shape is cached, since the coefficient of variation seldom changes
+    thread_local double cv = 0, k = 1;
+    if (dev / mean != cv) {
+        cv = dev / mean;
+        k = weibull_shape(cv);
+    }
+    double l = mean / std::tgamma(1 + 1/k);
+    return l * std::pow(-std::log(1 - counter_real(seed, uid, round, stream)), 1/k);
+}
+
+
+}
+
+#endif // FCPP_PHILOX_H_
@@ -0,0 +1,103 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file recovery_latency.hpp
+ * @brief Measurement of the convergence and recovery latency of election algorithms in single runs.
+ */
+
+#ifndef FCPP_RECOVERY_LATENCY_H_
+#define FCPP_RECOVERY_LATENCY_H_
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/fcpp.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Monitor of the agreement of nodes on the correct leader during a run.
+ *
+ * Before the disruption every node should elect device 0, after it device 1 (the surviving device
+ * with the smallest identifier). The latency of a phase is the time from its start until the round
+ * following the last one in which some alive node disagreed, or infinity if nodes still disagreed
+ * in the last round before the end of the simulation.
+ */
+class recovery_monitor {
+  public:
+    //! @brief number of algorithms monitored
+    static constexpr size_t algorithms = 4;
+
+    //! @brief constructor given the times of disruption and end of the simulation
+    recovery_monitor(times_t die_time, times_t end_time) : m_die_time(die_time), m_end_time(end_time) {
+        m_last.fill({{-1, -1}});
+    }
+
+    //! @brief the monitor of the run executed by the current thread (if any)
+    static recovery_monitor*& active() {
+        thread_local recovery_monitor* m = nullptr;
+        return m;
+    }
+
+    //! @brief records the leaders elected by the algorithms in a round of an alive node
+    void record(times_t t, bool perturbation, std::array<device_t, algorithms> const& leaders) {
+        if (t > m_end_time) return;
+        device_t expected = perturbation ? 1 : 0;
+        for (size_t a = 0; a < algorithms; ++a)
+            if (leaders[a] != expected) m_last[a][perturbation] = std::max(m_last[a][perturbation], double(t));
+    }
+
+    //! @brief time from the start of the simulation until every node elected device 0 (for an algorithm)
+    double convergence(size_t a) const {
+        return latency(m_last[a][0], 0, m_die_time);
+    }
+
+    //! @brief time from the disruption until every node elected device 1 (for an algorithm)
+    double recovery(size_t a) const {
+        return latency(m_last[a][1], m_die_time, m_end_time);
+    }
+
+  private:
+    //! @brief latency of a phase given the time of the last disagreement
+    static double latency(double last, double start, double end) {
+        if (last < 0) return 0;
+        if (last + 1 >= end) return std::numeric_limits<double>::infinity();
+        return last + 1 - start;
+    }
+
+    //! @brief time of disruption
+    times_t m_die_time;
+    //! @brief time of simulation end
+    times_t m_end_time;
+    //! @brief time of the last disagreement of each algorithm, before and after the disruption
+    std::array<std::array<double, 2>, algorithms> m_last;
+};
+
+
+//! @brief Prints a plot of several series, in the format understood by `plot.asy`.
+inline void series_plot(std::ostream& o, std::string const& path, std::string const& title, std::string const& xlabel, std::string const& ylabel, std::vector<std::string> const& names, std::vector<std::vector<std::pair<double, double>>> const& v) {
+    o << "plot.put(plot.plot(name+\"-" << path << "\", \"" << title << "\", \"" << xlabel << "\", \"" << ylabel << "\", new string[] {";
+    for (size_t i=0; i<names.size(); ++i) o << (i ? ", " : "") << "\"" << names[i] << "\"";
+    o << "}, new pair[][] {";
+    for (size_t i=0; i<v.size(); ++i) {
+        o << (i ? ", " : "") << "{";
+        for (size_t j=0; j<v[i].size(); ++j) o << (j ? ", " : "") << "(" << v[i][j].first << ", " << v[i][j].second << ")";
+        o << "}";
+    }
+    o << "}));\n\n";
+}
+
+
+}
+
+#endif // FCPP_RECOVERY_LATENCY_H_
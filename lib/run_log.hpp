@@ -0,0 +1,78 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file run_log.hpp
+ * @brief Reading of the log files produced by single simulation runs.
+ */
+
+#ifndef FCPP_RUN_LOG_H_
+#define FCPP_RUN_LOG_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lib/delta_log.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Prefix of the line closing a complete log.
+constexpr char const* log_footer = "# FCPP data export finished at:";
+
+
+//! @brief Whether a log file exists and has been completely written.
+bool log_complete(std::string const& path) {
+    std::ifstream in(path);
+    std::string line;
+    bool complete = false;
+    while (std::getline(in, line))
+        if (line.rfind(log_footer, 0) == 0)
+            complete = true;
+        else if (line.size() > 0 and line[0] != '#')
+            complete = false;
+    return complete;
+}
+
+/**
+ * @brief Reads the data rows of a log file, calling `f` on each of them.
+ *
+ * Rows are passed as vectors of values, the first of which is the time of the row.
+ * Comment lines (starting with `#`) are skipped. In change-only logs (see `delta_log.hpp`),
+ * the rows omitted are restored by repeating the previous row, so that the dense series is read.
+ */
+template <typename F>
+void read_log(std::string const& path, F&& f) {
+    std::ifstream in(path);
+    std::string line;
+    std::vector<double> row, last;
+    double period = 0;
+    while (std::getline(in, line)) {
+        if (line.rfind(delta_log_marker, 0) == 0) {
+            std::stringstream(line.substr(std::string(delta_log_marker).size())) >> period;
+            continue;
+        }
+        if (line.empty() or line[0] == '#') continue;
+        std::stringstream ss(line);
+        row.clear();
+        for (double x; ss >> x; ) row.push_back(x);
+        if (row.empty()) continue;
+        if (period > 0 and not last.empty())
+            for (double t = last[0] + period; t < row[0] - period/2; t += period) {
+                last[0] = t;
+                f(last);
+            }
+        f(row);
+        last = row;
+    }
+}
+
+
+}
+
+#endif // FCPP_RUN_LOG_H_
@@ -0,0 +1,304 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file seed_stats.hpp
+ * @brief Online reduction of simulation results across seeds (mean, variance and quantile sketches).
+ */
+
+#ifndef FCPP_SEED_STATS_H_
+#define FCPP_SEED_STATS_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/fcpp.hpp"
+#include "lib/phase_timers.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Running statistics of a real value: mean and variance (Welford), and a mergeable quantile sketch.
+class running_stats {
+  public:
+    //! @brief relative accuracy of the quantile sketch
+    static constexpr double accuracy = 0.02;
+
+    //! @brief inserts a new value
+    void insert(double x) {
+        ++m_count;
+        double d = x - m_mean;
+        m_mean += d / m_count;
+        m_m2 += d * (x - m_mean);
+        if (x > 0) add(m_positive, bucket(x), 1);
+        else if (x < 0) add(m_negative, bucket(-x), 1);
+        else ++m_zeros;
+    }
+
+    //! @brief merges statistics from another object (Chan's parallel formula)
+    void merge(running_stats const& o) {
+        if (o.m_count == 0) return;
+        size_t n = m_count + o.m_count;
+        double d = o.m_mean - m_mean;
+        m_m2 += o.m_m2 + d * d * m_count * o.m_count / n;
+        m_mean += d * o.m_count / n;
+        m_count = n;
+        m_zeros += o.m_zeros;
+        for (auto const& b : o.m_positive) add(m_positive, b.first, b.second);
+        for (auto const& b : o.m_negative) add(m_negative, b.first, b.second);
+    }
+
+    //! @brief number of values inserted
+    size_t count() const {
+        return m_count;
+    }
+
+    //! @brief mean of the values inserted
+    double mean() const {
+        return m_count > 0 ? m_mean : std::nan("");
+    }
+
+    //! @brief sample variance of the values inserted
+    double variance() const {
+        return m_count > 1 ? m_m2 / (m_count - 1) : 0;
+    }
+
+    //! @brief half-width of the confidence interval for the mean (normal approximation)
+    double error(double z = 1.96) const {
+        return m_count > 0 ? z * std::sqrt(variance() / m_count) : std::nan("");
+    }
+
+    //! @brief approximate q-quantile of the values inserted (relative error bounded by `accuracy`)
+    double quantile(double q) const {
+        if (m_count == 0) return std::nan("");
+        size_t rank = std::min(size_t(q * (m_count - 1)), m_count - 1);
+        size_t seen = 0;
+        for (auto it = m_negative.rbegin(); it != m_negative.rend(); ++it)
+            if ((seen += it->second) > rank) return -value(it->first);
+        if ((seen += m_zeros) > rank) return 0;
+        for (auto const& b : m_positive)
+            if ((seen += b.second) > rank) return value(b.first);
+        return value(m_positive.back().first);
+    }
+
+  private:
+    //! @brief type of the sketch buckets (index and count, sorted by index)
+    using buckets_t = std::vector<std::pair<int, size_t>>;
+
+    //! @brief the bucket of a positive value
+    static int bucket(double x) {
+        return std::ceil(std::log(x) / std::log(gamma()));
+    }
+
+    //! @brief the representative value of a bucket
+    static double value(int i) {
+        return 2 * std::pow(gamma(), i) / (gamma() + 1);
+    }
+
+    //! @brief base of the logarithmic buckets
+    static constexpr double gamma() {
+        return (1 + accuracy) / (1 - accuracy);
+    }
+
+    //! @brief adds a count to a bucket
+    static void add(buckets_t& v, int i, size_t c) {
+        auto it = std::lower_bound(v.begin(), v.end(), std::make_pair(i, size_t(0)));
+        if (it != v.end() and it->first == i) it->second += c;
+        else v.emplace(it, i, c);
+    }
+
+    //! @brief number of values
+    size_t m_count = 0;
+    //! @brief running mean
+    double m_mean = 0;
+    //! @brief running sum of squared differences from the mean
+    double m_m2 = 0;
+    //! @brief number of zero values
+    size_t m_zeros = 0;
+    //! @brief sketch buckets for positive and negative values
+    buckets_t m_positive, m_negative;
+};
+
+
+//! @brief A point of a plot with confidence band and quantile band.
+struct band_point {
+    //! @brief the abscissa
+    double x;
+    //! @brief the mean value
+    double mean;
+    //! @brief lower and upper bounds of the confidence band
+    double low, high;
+    //! @brief lower and upper quantiles of the values across seeds
+    double q_low, q_high;
+};
+
+
+/**
+ * @brief Reducer keeping running statistics across seeds for every configuration and time.
+ *
+ * Rows (as fed to plotters) are grouped by the values of the key tags `Ks` and by `plot::time`;
+ * the values of the column tags `Cs` are reduced into `running_stats` objects. Memory usage is
+ * thus bounded by the number of configurations and time steps, independently of the number of seeds.
+ *
+ * @param K The sequence of tags identifying a configuration.
+ * @param C The sequence of tags of the columns to be reduced.
+ */
+template <typename K, typename C>
+class seed_stats;
+
+//! @cond INTERNAL
+template <typename... Ks, typename... Cs>
+class seed_stats<common::type_sequence<Ks...>, common::type_sequence<Cs...>> {
+  public:
+    //! @brief the number of columns
+    static constexpr size_t columns = sizeof...(Cs);
+
+    //! @brief the quantiles bounding the quantile bands
+    static constexpr double q_low = 0.1, q_high = 0.9;
+
+    //! @brief type of the configuration keys
+    using key_type = std::array<double, sizeof...(Ks)>;
+
+    //! @brief type of the statistics for a given configuration and time
+    using row_type = std::array<running_stats, columns>;
+
+    //! @brief reduces a new row
+    template <typename R>
+    seed_stats& operator<<(R const& row) {
+        key_type k{double(common::get<Ks>(row))...};
+        size_t t = std::lround(common::get<plot::time>(row));
+        std::array<double, columns> v{double(common::get<Cs>(row))...};
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<row_type>& series = m_data[k];
+        if (series.size() <= t) series.resize(t+1);
+        for (size_t i=0; i<columns; ++i) series[t][i].insert(v[i]);
+        return *this;
+    }
+
+    //! @brief merges the statistics of another reducer
+    void merge(seed_stats const& o) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto const& kv : o.m_data) {
+            std::vector<row_type>& series = m_data[kv.first];
+            if (series.size() < kv.second.size()) series.resize(kv.second.size());
+            for (size_t t=0; t<kv.second.size(); ++t)
+                for (size_t i=0; i<columns; ++i)
+                    series[t][i].merge(kv.second[t][i]);
+        }
+    }
+
+    //! @brief access to the statistics by configuration key (and time)
+    std::map<key_type, std::vector<row_type>> const& data() const {
+        return m_data;
+    }
+
+    //! @brief the bands of a column over time, for a given configuration
+    std::vector<band_point> series(key_type const& k, size_t col) const {
+        std::vector<band_point> v;
+        auto it = m_data.find(k);
+        if (it == m_data.end()) return v;
+        for (size_t t=0; t<it->second.size(); ++t) {
+            running_stats const& s = it->second[t][col];
+            if (s.count() > 0) v.push_back({double(t), s.mean(), s.mean() - s.error(), s.mean() + s.error(), s.quantile(q_low), s.quantile(q_high)});
+        }
+        return v;
+    }
+
+    //! @brief the bands of a column for a given configuration, averaged over times above a threshold
+    band_point summary(key_type const& k, size_t col, double tmin) const {
+        band_point p{0, 0, 0, 0, 0, 0};
+        size_t n = 0;
+        for (band_point const& b : series(k, col)) if (b.x > tmin) {
+            p.mean   += b.mean;
+            p.low    += b.low;
+            p.high   += b.high;
+            p.q_low  += b.q_low;
+            p.q_high += b.q_high;
+            ++n;
+        }
+        if (n == 0) return {0, std::nan(""), std::nan(""), std::nan(""), std::nan(""), std::nan("")};
+        return {0, p.mean / n, p.low / n, p.high / n, p.q_low / n, p.q_high / n};
+    }
+
+  private:
+    //! @brief statistics by configuration and time
+    std::map<key_type, std::vector<row_type>> m_data;
+    //! @brief mutex regulating concurrent insertions
+    std::mutex m_mutex;
+};
+//! @endcond
+
+
+/**
+ * @brief Plotter feeding rows both to a base plotter `P` and to a reducer `S`.
+ *
+ * The plots built are the ones of the base plotter, while the reducer is accessible through `stats()`.
+ */
+template <typename P, typename S>
+class stats_plotter : public P {
+  public:
+    //! @brief feeds a new row to the plotter and the reducer
+    template <typename R>
+    stats_plotter& operator<<(R const& row) {
+        phase_timer timer(phase::plotting);
+        P::operator<<(row);
+        m_stats << row;
+        return *this;
+    }
+
+    //! @brief access to the reducer
+    //! @{
+    S& stats() {
+        return m_stats;
+    }
+    S const& stats() const {
+        return m_stats;
+    }
+    //! @}
+
+  private:
+    //! @brief the reducer
+    S m_stats;
+};
+
+
+//! @brief Prints a plot with confidence and quantile bands, in the format understood by `plot.asy`.
+inline void band_plot(std::ostream& o, std::string const& path, std::string const& title, std::string const& xlabel, std::string const& ylabel, std::string const& column, std::vector<band_point> const& v) {
+    std::string names[5] = {column + " (mean)", column + " (low)", column + " (high)", column + " (q10)", column + " (q90)"};
+    o << "plot.put(plot.plot(name+\"-" << path << "\", \"" << title << "\", \"" << xlabel << "\", \"" << ylabel << "\", new string[] {";
+    for (int i=0; i<5; ++i) o << (i ? ", " : "") << "\"" << names[i] << "\"";
+    o << "}, new pair[][] {";
+    for (int i=0; i<5; ++i) {
+        o << (i ? ", " : "") << "{";
+        for (size_t j=0; j<v.size(); ++j) {
+            double y = i == 0 ? v[j].mean : i == 1 ? v[j].low : i == 2 ? v[j].high : i == 3 ? v[j].q_low : v[j].q_high;
+            o << (j ? ", " : "") << "(" << v[j].x << ", " << y << ")";
+        }
+        o << "}";
+    }
+    o << "}));\n\n";
+}
+
+//! @brief Wraps plots with confidence bands into a file in the format understood by `plot.asy`.
+inline std::string band_file(std::string const& name, std::string const& plots, int cols = 3) {
+    std::stringstream ss;
+    ss << "// " << name << "\nstring name = \"" << name << "\";\n\nimport \"plot.asy\" as plot;\nunitsize(1cm);\n\n";
+    ss << "plot.ROWS = 1;\nplot.COLS = " << cols << ";\n\n" << plots << "\nshipout(\"" << name << "\");\n";
+    return ss.str();
+}
+
+
+}
+
+#endif // FCPP_SEED_STATS_H_
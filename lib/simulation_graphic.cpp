@@ -0,0 +1,12 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+#include "lib/simulation_graphic.hpp"
+
+namespace fcpp {
+
+// the interactive simulators, compiled once for all the programs linking them
+template class compiled_net<component::interactive_simulator<option::list<true>>, option::graphic_init_t>;
+template class compiled_net<component::interactive_simulator<option::list<false>>, option::graphic_init_t>;
+template class compiled_net<component::interactive_simulator<option::replay_list<true>>, option::graphic_init_t>;
+
+}
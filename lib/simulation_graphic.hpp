@@ -0,0 +1,58 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file simulation_graphic.hpp
+ * @brief Interactive simulators for the case study comparing election algorithms.
+ */
+
+#ifndef FCPP_SIMULATION_GRAPHIC_H_
+#define FCPP_SIMULATION_GRAPHIC_H_
+
+#include <string>
+
+#include "lib/simulation_setup.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+namespace option {
+
+//! @brief The parameters initialising an interactive simulation.
+using graphic_init_t = common::tagged_tuple_t<
+    name,       std::string,
+    sync,       bool,
+    seed,       int,
+    speed,      double,
+    dens,       double,
+    side,       double,
+    round_dev,  double,
+    dev_num,    size_t,
+    end_time,   times_t,
+    die_time,   times_t,
+    crash,      double,
+    plotter,    plot_t*,
+    area_min,   vec<2>,
+    area_max,   vec<2>
+>;
+
+//! @brief The interactive simulator with options `list<is_sync>`, compiled once in lib/simulation_graphic.cpp.
+template <bool is_sync>
+using compiled_graphic = compiled_simulator<component::interactive_simulator<list<is_sync>>, graphic_init_t>;
+
+//! @brief The interactive simulator replaying a trace, compiled once in lib/simulation_graphic.cpp.
+using compiled_replay = compiled_simulator<component::interactive_simulator<replay_list<true>>, graphic_init_t>;
+
+}
+
+//! @cond INTERNAL
+extern template class compiled_net<component::interactive_simulator<option::list<true>>, option::graphic_init_t>;
+extern template class compiled_net<component::interactive_simulator<option::list<false>>, option::graphic_init_t>;
+extern template class compiled_net<component::interactive_simulator<option::replay_list<true>>, option::graphic_init_t>;
+//! @endcond
+
+}
+
+#endif // FCPP_SIMULATION_GRAPHIC_H_
@@ -1,3 +1,12 @@
 // Copyright © 2022 Giorgio Audrito. All Rights Reserved.
 
 #include "lib/simulation_setup.hpp"
+
+namespace fcpp {
+
+// the batch simulators, compiled once for all the programs linking them
+template class compiled_net<component::batch_simulator<option::list<true>>, option::batch_init_t>;
+template class compiled_net<component::batch_simulator<option::list<false>>, option::batch_init_t>;
+template class compiled_net<component::batch_simulator<option::parallel_list<false>>, option::batch_init_t>;
+
+}
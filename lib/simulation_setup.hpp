@@ -9,7 +9,9 @@
 #define FCPP_SIMULATION_SETUP_H_
 
 #include "lib/fcpp.hpp"
+#include "lib/compiled_net.hpp"
 #include "lib/election_compare.hpp"
+#include "lib/seed_stats.hpp"
 
 
 /**
@@ -29,10 +31,11 @@ struct dens {};      // average density                     = 10, 20, 30
 //     side          // number of hops                      = 10, 20, 40
 //     speed         // maximum movement speed              = 0, 0.25, 0.5
 struct dev_num {};   // total number of devices             = dens*side*2/π
-struct round_dev {}; // standard deviation in round length  = sync ? 0 : 0.25
+//     round_dev     // standard deviation in round length  = sync ? 0 : 0.25
 //     end_time      // time for end simulation             = 10*side
 //     die_time      // time for disruption                 = 5*side
 struct simtype {};   // type of the simulation
+struct log_path {};  // path of the log file of a run (if written)
 
                      // total complexity of simulation      = (2*dens*side)^2
 
@@ -40,37 +43,39 @@ using d0 = distribution::constant_n<times_t, 0>;
 using d1 = distribution::constant_n<times_t, 1>;
 using d2 = distribution::constant_n<times_t, 2>;
 
+// dev_num devices for every replica of the active ensemble (for one replica without ensembles)
 template <bool is_sync>
 using spawn_s = sequence::multiple<
-    distribution::constant_i<size_t, dev_num>,
+    replica_devices<dev_num>,
     distribution::interval_n<times_t, 0, is_sync ? 0 : 20>,
     is_sync
 >;
 
-using round_s = sequence::periodic<
-    distribution::weibull<d1, d0, void, round_dev>,
-    distribution::weibull<d1, d0, void, round_dev>
->;
+// first rounds are one (random) round length after spawning, further lengths are drawn by the nodes through a counter-based generator
+using round_s = timed_sequence<sequence::periodic<distribution::weibull<d1, d0, void, round_dev>, d1>>;
 
 using export_s = sequence::periodic<d0, d1, distribution::constant_i<times_t, end_time>>;
 
 using rectangle_d = distribution::rect<d0, d0, distribution::constant_i<double, side>, d2>;
 
 using aggregator_t = aggregators<
-    leaders<GCF>,               aggregator::distinct<device_t>,
-    leaders<Datta>,             aggregator::distinct<device_t>,
-    leaders<GCF__filtered>,     aggregator::distinct<device_t>,
-    leaders<Datta__filtered>,   aggregator::distinct<device_t>,
-
-    correct<GCF>,               aggregator::sum<int>,
-    correct<Datta>,             aggregator::sum<int>,
-    correct<GCF__filtered>,     aggregator::sum<int>,
-    correct<Datta__filtered>,   aggregator::sum<int>,
-
-    spurious<GCF>,              aggregator::sum<int>,
-    spurious<Datta>,            aggregator::sum<int>,
-    spurious<GCF__filtered>,    aggregator::sum<int>,
-    spurious<Datta__filtered>,  aggregator::sum<int>
+    leaders<GCF>,               timed_aggregator<aggregator::distinct<device_t>>,
+    leaders<Datta>,             timed_aggregator<aggregator::distinct<device_t>>,
+    leaders<GCF__filtered>,     timed_aggregator<aggregator::distinct<device_t>>,
+    leaders<Datta__filtered>,   timed_aggregator<aggregator::distinct<device_t>>,
+
+    correct<GCF>,               timed_aggregator<aggregator::sum<int>>,
+    correct<Datta>,             timed_aggregator<aggregator::sum<int>>,
+    correct<GCF__filtered>,     timed_aggregator<aggregator::sum<int>>,
+    correct<Datta__filtered>,   timed_aggregator<aggregator::sum<int>>,
+
+    spurious<GCF>,              timed_aggregator<aggregator::sum<int>>,
+    spurious<Datta>,            timed_aggregator<aggregator::sum<int>>,
+    spurious<GCF__filtered>,    timed_aggregator<aggregator::sum<int>>,
+    spurious<Datta__filtered>,  timed_aggregator<aggregator::sum<int>>,
+
+    neighbours,                 timed_aggregator<aggregator::mean<double>>,
+    neighbours,                 timed_aggregator<aggregator::max<double>>
 >;
 
 template <typename xvar>
@@ -84,7 +89,39 @@ using plot_var_row_t = plot::filter<plot::time, filter::above<100>, plot_row_t<x
 template <typename xvar, int n, typename svar>
 using plot_var_t = plot::filter<simtype, filter::equal<n>, plot::split<common::type_sequence<sync, svar>, plot_var_row_t<xvar>>>;
 
-using plot_t = plot::join<plot_var_t<speed, 1, crash>, plot_var_t<crash, 2, speed>, plot_time_t>;
+using plot_base_t = plot::join<plot_var_t<speed, 1, crash>, plot_var_t<crash, 2, speed>, plot_time_t>;
+
+//! @brief Tags identifying a configuration in the cross-seed statistics.
+using stats_key_t = common::type_sequence<sync, speed, crash, simtype>;
+
+//! @brief Columns reduced in the cross-seed statistics (in the order of `aggregator_t`).
+using stats_columns_t = common::type_sequence<
+    aggregator::distinct<leaders<GCF>>,     aggregator::distinct<leaders<Datta>>,
+    aggregator::distinct<leaders<GCF__filtered>>, aggregator::distinct<leaders<Datta__filtered>>,
+    aggregator::sum<correct<GCF>>,          aggregator::sum<correct<Datta>>,
+    aggregator::sum<correct<GCF__filtered>>,    aggregator::sum<correct<Datta__filtered>>,
+    aggregator::sum<spurious<GCF>>,         aggregator::sum<spurious<Datta>>,
+    aggregator::sum<spurious<GCF__filtered>>,   aggregator::sum<spurious<Datta__filtered>>
+>;
+
+//! @brief Names of the columns reduced in the cross-seed statistics.
+const std::vector<std::string> stats_names = {
+    "distinct(leaders<GCF>)", "distinct(leaders<Datta>)", "distinct(leaders<GCF__filtered>)", "distinct(leaders<Datta__filtered>)",
+    "sum(correct<GCF>)", "sum(correct<Datta>)", "sum(correct<GCF__filtered>)", "sum(correct<Datta__filtered>)",
+    "sum(spurious<GCF>)", "sum(spurious<Datta>)", "sum(spurious<GCF__filtered>)", "sum(spurious<Datta__filtered>)"
+};
+
+//! @brief Further parameters recorded in the telemetry of runs.
+using telemetry_params_t = common::type_sequence<seed, dens, side, dev_num, end_time>;
+
+//! @brief Names of the parameters recorded in the telemetry of runs (`stats_key_t` and `telemetry_params_t`).
+const std::vector<std::string> telemetry_names = {
+    "sync", "speed", "crash", "simtype", "seed", "dens", "side", "dev_num", "end_time"
+};
+
+using stats_t = seed_stats<stats_key_t, stats_columns_t>;
+
+using plot_t = stats_plotter<plot_base_t, stats_t>;
 
 
 template <bool is_sync>
@@ -109,6 +146,10 @@ DECLARE_OPTIONS(list,
         crash,                      double,
         die_time,                   times_t,
         end_time,                   times_t,
+        round_dev,                  double,
+        run_seed,                   uint32_t,
+        round_count,                uint32_t,
+        replica_size,               device_t,
 
         node_size,                  double,
         node_shape,                 shape,
@@ -128,29 +169,77 @@ DECLARE_OPTIONS(list,
         spurious<GCF>,              int,
         spurious<Datta>,            int,
         spurious<GCF__filtered>,    int,
-        spurious<Datta__filtered>,  int
+        spurious<Datta__filtered>,  int,
+
+        neighbours,                 double
     >,
     extra_info<sync, int, speed, double, crash, double, simtype, int>,
     plot_type<plot_t>,
     spawn_schedule<spawn_s<is_sync>>,
     init<
-        x,          rectangle_d,
+        x,          mobility_start<replica_start<rectangle_d, dev_num>>,
         seed,       functor::cast<distribution::interval_n<double, 0, 1<<30>, uint_fast32_t>,
+        run_seed,   distribution::constant_i<uint32_t, seed>,
         side,       distribution::constant_i<double, side>,
         speed,      distribution::constant_i<double, speed>,
         round_dev,  distribution::constant_i<double, round_dev>,
         crash,      distribution::constant_i<double, crash>,
         die_time,   distribution::constant_i<times_t, die_time>,
-        end_time,   distribution::constant_i<times_t, end_time>
+        end_time,   distribution::constant_i<times_t, end_time>,
+        replica_size, distribution::constant_i<device_t, dev_num>
     >,
-    connector<connect::fixed<>>,
+    connector<timed_connector<connect::fixed<>>>,
     size_tag<node_size>,
     shape_tag<node_shape>,
     color_tag<gcf_color, datta_color>
 );
 
+//! @brief The options for replaying a recorded trace (as `list`, but with the replay program).
+template <bool is_sync>
+DECLARE_OPTIONS(replay_list,
+    program<coordination::replay>,
+    list<is_sync>
+);
+
+//! @brief The options for a single large simulation, whose nodes are processed by all available threads (as `list`, but parallel).
+template <bool is_sync>
+DECLARE_OPTIONS(parallel_list,
+    parallel<true>,
+    list<is_sync>
+);
+
+//! @brief The parameters initialising a batch simulation (as produced by the batch sequences).
+using batch_init_t = common::tagged_tuple_t<
+    seed,       int,
+    sync,       bool,
+    speed,      double,
+    crash,      double,
+    dens,       double,
+    side,       double,
+    simtype,    int,
+    output,     std::ostream*,
+    plotter,    plot_t*,
+    round_dev,  double,
+    dev_num,    size_t,
+    end_time,   times_t,
+    die_time,   times_t
+>;
+
+//! @brief The batch simulator with options `list<is_sync>`, compiled once in lib/simulation_setup.cpp.
+template <bool is_sync>
+using compiled_batch = compiled_simulator<component::batch_simulator<list<is_sync>>, batch_init_t>;
+
+//! @brief The asynchronous batch simulator with options `parallel_list<false>`, compiled once in lib/simulation_setup.cpp.
+using compiled_parallel = compiled_simulator<component::batch_simulator<parallel_list<false>>, batch_init_t>;
+
 }
 
+//! @cond INTERNAL
+extern template class compiled_net<component::batch_simulator<option::list<true>>, option::batch_init_t>;
+extern template class compiled_net<component::batch_simulator<option::list<false>>, option::batch_init_t>;
+extern template class compiled_net<component::batch_simulator<option::parallel_list<false>>, option::batch_init_t>;
+//! @endcond
+
 }
 
 #endif // FCPP_SIMULATION_SETUP_H_
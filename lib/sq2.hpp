@@ -71,14 +71,15 @@ class sq2 {
     }
     //! @}
 
-    //! @brief 3-way comparison
+    //! @brief 3-way comparison (squares are computed in 128 bits, to avoid overflows)
     double compare(const sq2& o) const {
         if (a > o.a and b > o.b) return 1;
         if (a < o.a and b < o.b) return -1;
+        __int128 da = a - o.a, db = b - o.b;
         if (a >= o.a and b <= o.b) {
-            return (a - o.a)*(a - o.a) - 2*(o.b - b)*(o.b - b);
+            return double(da*da - 2*db*db);
         }
-        return 2*(b - o.b)*(b - o.b) - (o.a - a)*(o.a - a);
+        return double(2*db*db - da*da);
     }
 
     //! @brief read-only access to coefficients
@@ -0,0 +1,134 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file telemetry.hpp
+ * @brief Progress reporting and per-run resource telemetry of batch executions.
+ */
+
+#ifndef FCPP_TELEMETRY_H_
+#define FCPP_TELEMETRY_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "lib/alloc_stats.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Telemetry of batch runs, appending a JSON line for every run and reporting progress on stderr.
+ *
+ * Every record holds the parameters of the run, its wall-clock time, the node rounds simulated per
+ * second, and the peak resident set size of the whole process when the run ended (which is shared
+ * by the runs executing concurrently, and never decreases). Progress is reported per sequence of
+ * runs, as sequences are executed one after the other and later ones (as the refinements of adaptive
+ * sweeps) may not be known when earlier ones start.
+ */
+class run_telemetry {
+  public:
+    //! @brief clock type
+    using clock_t = std::chrono::steady_clock;
+
+    //! @brief constructor given the path of the JSON-lines file (none if empty)
+    run_telemetry(std::string const& path = "") {
+        if (path.size()) m_out.open(path, std::ios::app);
+    }
+
+    //! @brief whether the current thread executes runs (set by their executor)
+    static bool& runner() {
+        thread_local bool b = false;
+        return b;
+    }
+
+    //! @brief node rounds executed by the current thread (if it executes runs)
+    static uint64_t& rounds() {
+        thread_local uint64_t n = 0;
+        return n;
+    }
+
+    //! @brief node rounds executed by other threads, as the worker threads of parallel runs
+    static std::atomic<uint64_t>& worker_rounds() {
+        static std::atomic<uint64_t> n{0};
+        return n;
+    }
+
+    //! @brief counts a node round in the current thread
+    static void round() {
+        if (runner()) ++rounds();
+        else worker_rounds().fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Node rounds executed so far by the runs of the current thread and by worker threads.
+     *
+     * The difference of two values taken by a thread around a run counts the rounds of the run, as
+     * long as parallel runs are not executed concurrently with other runs.
+     */
+    static uint64_t run_rounds() {
+        return rounds() + worker_rounds();
+    }
+
+    //! @brief starts tracking a sequence of a number of runs (after the previous sequence ended)
+    void start(size_t total) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_sequence;
+        m_total = total;
+        m_done = 0;
+        m_start = m_last = clock_t::now();
+    }
+
+    /**
+     * @brief Records a completed run.
+     *
+     * @param params A string with the JSON fields of the parameters of the run.
+     * @param seconds The wall-clock time of the run.
+     * @param events The node rounds simulated by the run.
+     */
+    void record(std::string const& params, double seconds, uint64_t events) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_done;
+        ++m_runs;
+        if (m_out.is_open()) {
+            m_out << "{" << params << (params.size() ? ", " : "") << "\"seconds\": " << seconds << ", \"events\": " << events
+                  << ", \"events_per_second\": " << (seconds > 0 ? events / seconds : 0) << ", \"process_peak_rss_kb\": " << alloc_stats::peak_rss() << "}\n";
+            m_out.flush();
+        }
+        clock_t::time_point now = clock_t::now();
+        // progress is reported at most once per second, and at the end
+        if (now - m_last < std::chrono::seconds(1) and m_done < m_total) return;
+        m_last = now;
+        double elapsed = std::chrono::duration<double>(now - m_start).count();
+        double eta = elapsed / m_done * (m_total - m_done);
+        std::cerr << "\rsequence " << m_sequence << ": " << m_done << "/" << m_total << " runs, " << std::fixed << std::setprecision(0) << elapsed << "s elapsed, ETA " << eta << "s (" << m_runs << " runs in all)  " << std::defaultfloat << std::setprecision(6);
+        if (m_done == m_total) std::cerr << std::endl;
+    }
+
+  private:
+    //! @brief the JSON-lines file
+    std::ofstream m_out;
+    //! @brief mutex regulating concurrent records
+    std::mutex m_mutex;
+    //! @brief number of the current sequence, and its runs to be done and done
+    size_t m_sequence = 0, m_total = 0, m_done = 0;
+    //! @brief runs done in all sequences
+    size_t m_runs = 0;
+    //! @brief start time of the current sequence and time of the last progress report
+    clock_t::time_point m_start, m_last;
+};
+
+
+}
+
+#endif // FCPP_TELEMETRY_H_
@@ -0,0 +1,444 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file trace.hpp
+ * @brief Compact delta-encoded traces of simulations, for recording and replaying them.
+ */
+
+#ifndef FCPP_TRACE_H_
+#define FCPP_TRACE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief State of a node in a trace.
+struct trace_state {
+    //! @brief position (in trace units)
+    int32_t x = 0, y = 0;
+    //! @brief leaders elected by the filtered algorithms
+    uint32_t gcf = 0, datta = 0;
+    //! @brief shape and size (in trace units) of the node
+    uint8_t shape = 0;
+    int32_t size = 0;
+    //! @brief whether the node is alive
+    bool alive = false;
+};
+
+
+//! @brief Common definitions of trace readers and writers.
+struct trace_format {
+    //! @brief magic number opening and closing trace files
+    static constexpr uint32_t magic = 0x52544c45; // "ELTR"
+    //! @brief resolution of times and lengths
+    static constexpr double unit = 1000;
+    //! @brief time between consecutive keyframes
+    static constexpr double keyframe_period = 10;
+
+    //! @brief record types
+    enum record : uint8_t { update, keyframe, end };
+
+    //! @brief flags of an update record
+    enum flags : uint8_t { moved = 1, leaders = 2, looks = 4, terminated = 8 };
+
+    //! @brief header of a trace
+    struct header {
+        //! @brief number of nodes
+        uint32_t nodes;
+        //! @brief side of the area
+        double side;
+        //! @brief end of the recorded simulation
+        double end_time;
+    };
+
+    //! @brief quantisation of a real value
+    static int32_t quantise(double x) {
+        return std::lround(x * unit);
+    }
+
+    //! @brief dequantisation of a real value
+    static double real(int64_t x) {
+        return x / unit;
+    }
+};
+
+
+/**
+ * @brief Writer of a trace, recording node updates as deltas from the previous state of the node.
+ *
+ * The full state of all nodes is repeated in periodic keyframes, whose offsets are written in an index
+ * at the end of the file, so that readers can seek to any time.
+ */
+class trace_writer : public trace_format {
+  public:
+    //! @brief constructor given the path and the header
+    trace_writer(std::string const& path, header const& h) : m_out(path, std::ios::binary), m_states(h.nodes) {
+        uint32_t m = magic;
+        write_raw(m);
+        // fields are written one by one, so that the format does not depend on the layout of the header
+        write_raw(h.nodes);
+        write_raw(h.side);
+        write_raw(h.end_time);
+    }
+
+    //! @brief closes the trace
+    ~trace_writer() {
+        close();
+    }
+
+    //! @brief the trace currently recording (if any)
+    static trace_writer*& active() {
+        static trace_writer* w = nullptr;
+        return w;
+    }
+
+    //! @brief records the state of a node at a given time
+    void record(double t, uint32_t uid, trace_state s) {
+        if (uid >= m_states.size()) m_states.resize(uid+1);
+        int64_t qt = quantise(t);
+        while (qt >= m_next_keyframe) write_keyframe();
+        trace_state& o = m_states[uid];
+        uint8_t f = (s.x != o.x or s.y != o.y ? moved : 0) | (s.gcf != o.gcf or s.datta != o.datta ? leaders : 0) | (s.shape != o.shape or s.size != o.size ? looks : 0) | (s.alive ? 0 : terminated);
+        put(update);
+        put_varint(uid);
+        put_varint(zigzag(qt - m_time));
+        put(f);
+        if (f & moved) {
+            put_varint(zigzag(int64_t(s.x) - o.x));
+            put_varint(zigzag(int64_t(s.y) - o.y));
+        }
+        if (f & leaders) {
+            put_varint(s.gcf);
+            put_varint(s.datta);
+        }
+        if (f & looks) {
+            put(s.shape);
+            put_varint(zigzag(s.size));
+        }
+        m_time = qt;
+        o = s;
+    }
+
+    //! @brief writes the index and closes the trace
+    void close() {
+        if (not m_out.is_open()) return;
+        put(end);
+        flush();
+        uint64_t offset = m_out.tellp();
+        uint64_t n = m_index.size();
+        write_raw(n);
+        for (auto const& k : m_index) write_raw(k);
+        uint32_t m = magic;
+        write_raw(offset);
+        write_raw(m);
+        m_out.close();
+    }
+
+  private:
+    //! @brief writes a keyframe with the full state of the live nodes
+    void write_keyframe() {
+        flush();
+        m_index.emplace_back(m_next_keyframe, uint64_t(m_out.tellp()));
+        put(keyframe);
+        put_varint(zigzag(m_next_keyframe));
+        m_time = m_next_keyframe;
+        m_next_keyframe += quantise(keyframe_period);
+        uint32_t n = 0;
+        // dead nodes are forgotten, so that readers can start decoding from here
+        for (trace_state& s : m_states) {
+            if (not s.alive) s = trace_state{};
+            n += s.alive;
+        }
+        put_varint(n);
+        for (uint32_t uid=0; uid<m_states.size(); ++uid) if (m_states[uid].alive) {
+            trace_state const& s = m_states[uid];
+            put_varint(uid);
+            put_varint(zigzag(s.x));
+            put_varint(zigzag(s.y));
+            put_varint(s.gcf);
+            put_varint(s.datta);
+            put(s.shape);
+            put_varint(zigzag(s.size));
+        }
+    }
+
+    //! @brief zigzag encoding of a signed integer
+    static uint64_t zigzag(int64_t x) {
+        return (uint64_t(x) << 1) ^ uint64_t(x >> 63);
+    }
+
+    //! @brief buffers a byte
+    void put(uint8_t b) {
+        m_buffer.push_back(b);
+        if (m_buffer.size() >= (1<<16)) flush();
+    }
+
+    //! @brief buffers a variable-length integer
+    void put_varint(uint64_t x) {
+        for (; x >= 128; x >>= 7) put(uint8_t(x | 128));
+        put(uint8_t(x));
+    }
+
+    //! @brief writes the buffer to file
+    void flush() {
+        m_out.write(reinterpret_cast<char const*>(m_buffer.data()), m_buffer.size());
+        m_buffer.clear();
+    }
+
+    //! @brief writes a raw value to file
+    template <typename T>
+    void write_raw(T const& x) {
+        m_out.write(reinterpret_cast<char const*>(&x), sizeof(T));
+    }
+
+    //! @brief the output file
+    std::ofstream m_out;
+    //! @brief buffered bytes
+    std::vector<uint8_t> m_buffer;
+    //! @brief last state of every node
+    std::vector<trace_state> m_states;
+    //! @brief index of keyframes (time and offset)
+    std::vector<std::pair<int64_t, uint64_t>> m_index;
+    //! @brief time of the last record
+    int64_t m_time = 0;
+    //! @brief time of the next keyframe
+    int64_t m_next_keyframe = 0;
+};
+
+
+/**
+ * @brief Player of a trace, reconstructing the state of nodes at any time.
+ *
+ * Moving forward in time only decodes the records in between. The changes decoded since the last
+ * keyframe are kept in a journal (with the states before and after them), so that moving backwards
+ * within the same keyframe period only undoes the changes in between, and moving forward again redoes
+ * them without decoding. Only moving before the last keyframe restarts decoding from an earlier one.
+ */
+class trace_player : public trace_format {
+  public:
+    //! @brief constructor given the path
+    trace_player(std::string const& path) : m_in(path, std::ios::binary) {
+        uint32_t m = 0;
+        read_raw(m);
+        read_raw(m_header.nodes);
+        read_raw(m_header.side);
+        read_raw(m_header.end_time);
+        m_ok = m == magic;
+        m_states.resize(m_header.nodes);
+        m_in.seekg(-int(sizeof(uint64_t) + sizeof(uint32_t)), std::ios::end);
+        uint64_t offset = 0;
+        read_raw(offset);
+        read_raw(m);
+        m_ok = m_ok and m == magic;
+        m_in.seekg(offset);
+        uint64_t n = 0;
+        read_raw(n);
+        m_index.resize(m_ok ? n : 0);
+        for (auto& k : m_index) read_raw(k);
+        m_ok = m_ok and not m_index.empty();
+    }
+
+    //! @brief whether the trace has been read correctly
+    bool good() const {
+        return m_ok;
+    }
+
+    //! @brief the header of the trace
+    header const& info() const {
+        return m_header;
+    }
+
+    //! @brief the trace currently replaying (if any)
+    static trace_player*& active() {
+        static trace_player* p = nullptr;
+        return p;
+    }
+
+    //! @brief sets the trace time corresponding to simulated time zero, and the replay rate (negative to play backwards)
+    void set_clock(double start, double rate) {
+        m_start = start;
+        m_rate = rate;
+    }
+
+    //! @brief the trace time corresponding to a simulated time
+    double time(double t) const {
+        return m_start + m_rate * t;
+    }
+
+    //! @brief the state of a node at a given time
+    trace_state const& state(uint32_t uid, double t) {
+        seek(t);
+        static const trace_state none;
+        return uid < m_states.size() ? m_states[uid] : none;
+    }
+
+    //! @brief moves the state of nodes to a given time
+    void seek(double t) {
+        if (not m_ok) return;
+        int64_t qt = quantise(t);
+        if (m_time < 0 or qt < m_key_time) {
+            // restart from the last keyframe before the time (unless it is the current one)
+            auto it = std::upper_bound(m_index.begin(), m_index.end(), std::make_pair(qt, uint64_t(-1)));
+            if (it != m_index.begin()) --it;
+            if (m_time < 0 or it->first != m_key_time) {
+                m_in.clear();
+                m_in.seekg(it->second);
+                for (trace_state& s : m_states) s = trace_state{};
+                m_journal.clear();
+                m_cursor = 0;
+                m_time = m_key_time = it->first;
+                m_next = next_record();
+            }
+        }
+        // undoes the journaled changes after the time
+        for (; m_cursor > 0 and m_journal[m_cursor-1].time > qt; --m_cursor) {
+            m_states[m_journal[m_cursor-1].uid] = m_journal[m_cursor-1].before;
+            m_time = m_journal[m_cursor-1].previous;
+        }
+        // redoes the journaled changes up to the time
+        for (; m_cursor < m_journal.size() and m_journal[m_cursor].time <= qt; ++m_cursor) {
+            m_states[m_journal[m_cursor].uid] = m_journal[m_cursor].after;
+            m_time = m_journal[m_cursor].time;
+        }
+        // decodes further changes up to the time
+        if (m_cursor == m_journal.size())
+            while (m_next != end and m_next_time <= qt) apply();
+    }
+
+  private:
+    //! @brief a change of the state of a node, as recorded in the journal
+    struct change {
+        //! @brief time of the change, and of the record before it
+        int64_t time, previous;
+        //! @brief the node changed
+        uint32_t uid;
+        //! @brief the state of the node before and after the change
+        trace_state before, after;
+    };
+
+    //! @brief reads the type and time of the next record
+    uint8_t next_record() {
+        uint8_t r = get();
+        if (r == update) {
+            m_next_uid = get_varint();
+            m_next_time = m_time + unzigzag(get_varint());
+        } else if (r == keyframe) {
+            m_next_time = unzigzag(get_varint());
+        } else r = end;
+        return r;
+    }
+
+    //! @brief applies the next record
+    void apply() {
+        int64_t previous = m_time;
+        m_time = m_next_time;
+        if (m_next == keyframe) {
+            // a new keyframe period, with an empty journal
+            m_journal.clear();
+            m_cursor = 0;
+            m_key_time = m_time;
+            for (trace_state& s : m_states) s = trace_state{};
+            for (uint64_t n = get_varint(); n > 0; --n) {
+                uint32_t uid = get_varint();
+                if (uid >= m_states.size()) m_states.resize(uid+1);
+                trace_state& s = m_states[uid];
+                s.x = unzigzag(get_varint());
+                s.y = unzigzag(get_varint());
+                s.gcf = get_varint();
+                s.datta = get_varint();
+                s.shape = get();
+                s.size = unzigzag(get_varint());
+                s.alive = true;
+            }
+        } else {
+            if (m_next_uid >= m_states.size()) m_states.resize(m_next_uid+1);
+            trace_state& s = m_states[m_next_uid];
+            trace_state before = s;
+            uint8_t f = get();
+            if (f & moved) {
+                s.x += unzigzag(get_varint());
+                s.y += unzigzag(get_varint());
+            }
+            if (f & leaders) {
+                s.gcf = get_varint();
+                s.datta = get_varint();
+            }
+            if (f & looks) {
+                s.shape = get();
+                s.size = unzigzag(get_varint());
+            }
+            s.alive = not (f & terminated);
+            m_journal.push_back({m_time, previous, m_next_uid, before, s});
+            ++m_cursor;
+        }
+        m_next = next_record();
+    }
+
+    //! @brief zigzag decoding of a signed integer
+    static int64_t unzigzag(uint64_t x) {
+        return int64_t(x >> 1) ^ -int64_t(x & 1);
+    }
+
+    //! @brief reads a byte
+    uint8_t get() {
+        int c = m_in.get();
+        return c == EOF ? uint8_t(end) : uint8_t(c);
+    }
+
+    //! @brief reads a variable-length integer
+    uint64_t get_varint() {
+        uint64_t x = 0;
+        for (int s = 0; ; s += 7) {
+            uint8_t b = get();
+            x |= uint64_t(b & 127) << s;
+            if (b < 128 or s > 63) return x;
+        }
+    }
+
+    //! @brief reads a raw value from file
+    template <typename T>
+    void read_raw(T& x) {
+        m_in.read(reinterpret_cast<char*>(&x), sizeof(T));
+    }
+
+    //! @brief the input file
+    std::ifstream m_in;
+    //! @brief the header
+    header m_header{0, 0, 0};
+    //! @brief whether the trace has been read correctly
+    bool m_ok;
+    //! @brief index of keyframes (time and offset)
+    std::vector<std::pair<int64_t, uint64_t>> m_index;
+    //! @brief current state of every node
+    std::vector<trace_state> m_states;
+    //! @brief trace time at simulated time zero, and replay rate
+    double m_start = 0, m_rate = 1;
+    //! @brief time of the last record applied (negative before the start)
+    int64_t m_time = -1;
+    //! @brief time of the last keyframe applied
+    int64_t m_key_time = 0;
+    //! @brief changes applied since the last keyframe
+    std::vector<change> m_journal;
+    //! @brief number of changes in the journal currently applied
+    size_t m_cursor = 0;
+    //! @brief type, time and node of the next record
+    uint8_t m_next = end;
+    int64_t m_next_time = 0;
+    uint32_t m_next_uid = 0;
+};
+
+
+}
+
+#endif // FCPP_TRACE_H_
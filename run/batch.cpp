@@ -6,6 +6,13 @@
  */
 
 
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+#include "lib/adaptive_sweep.hpp"
+#include "lib/batch_runner.hpp"
+#include "lib/decimate.hpp"
 #include "lib/simulation_setup.hpp"
 
 using namespace fcpp;
@@ -13,23 +20,81 @@ using namespace fcpp;
 //! @brief Number of identical runs to be averaged.
 constexpr int runs = 50;
 
+//! @brief Maximum number of points in each plot (zero for no decimation).
+constexpr size_t plot_points = 600;
+
+//! @brief Whether the speed and crash sweeps are refined adaptively (instead of evaluating the whole grid).
+constexpr bool adaptive_sweeps = true;
+
+//! @brief Whether to write a log file for every single run by default (statistics are reduced in memory anyways).
+constexpr bool seed_files = false;
+
+//! @brief File receiving a JSON line with the parameters and resource usage of every run (none if empty).
+constexpr char const* telemetry_file = "output/batch-telemetry.jsonl";
+
+//! @brief File rewritten with the plots of the results so far in progressive mode (`--progressive seconds`).
+constexpr char const* partial_plot = "plot/batch-partial.asy";
+
+//! @brief Time between rows written anyways in the log files of single runs, even if unchanged (zero for dense logs).
+constexpr double log_keyframes = 50;
+
 //! @brief The plotter object.
 option::plot_t p;
 
-//! @brief Builds a sequence of parameters initialising the simulation.
-auto make_parameters(bool is_sync, int runs, std::string var = "none") {
+//! @brief The plotter object of the large simulation (`--large side`), written to `plot/batch-large.asy`.
+option::plot_t large_p;
+
+//! @brief Stream buffer discarding everything written into it.
+struct discard_buffer : public std::streambuf {
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(char const*, std::streamsize n) override {
+        return n;
+    }
+};
+
+//! @brief Stream discarding the logs of single runs (if not written on file).
+discard_buffer discard_buf;
+std::ostream discard(&discard_buf);
+
+//! @brief The change-only logs of single runs.
+delta_log_pool logs;
+
+//! @brief Builds the output parameter: a change-only log file per run (in the stringified path).
+auto make_output(std::true_type) {
+    return batch::formula<option::output>([](auto const& t) -> std::ostream* {
+        // rows are exported once per time unit
+        return logs.make(common::get<option::log_path>(t), 1, log_keyframes);
+    });
+}
+
+//! @brief Builds the output parameter: the discarding stream.
+auto make_output(std::false_type) {
+    return batch::constant<option::output>(&discard);
+}
+
+//! @brief Builds a sequence of parameters initialising the simulation (restricted to some grid points of the swept variable, if given).
+template <bool files>
+auto make_parameters(bool is_sync, int runs, std::string var = "none", std::vector<int> points = {}, int seed_batch = 0) {
     using namespace option;
     return batch::make_tagged_tuple_sequence(
-        batch::arithmetic<seed>(0, runs-1, 1),
+        batch::arithmetic<seed>(seed_batch*runs, (seed_batch+1)*runs-1, 1),
         batch::constant<sync>(is_sync),
         batch::arithmetic<speed>(0, 59, var == "speed" ? 1 : var == "none" ? 30 : 100),
         batch::arithmetic<crash>(0.0, 5.99, var == "prob" ? 0.1 : var == "none" ? 3 : 10),
         batch::arithmetic<dens>(10 + 10 * (var != "dens"), 40, 30),
         batch::arithmetic<side>(10 + 10 * (var != "side"), 40, 30),
         batch::constant<simtype>(var == "none" ? 0 : var == "speed" ? 1 : var == "prob" ? 2 : -1),
-        batch::stringify<output>("output/batch", "txt"),
+        batch::stringify<log_path>("output/batch", "txt"),
+        make_output(std::integral_constant<bool, files>{}),
         batch::constant<plotter>(&p),
-        batch::filter([&](auto const& t){
+        batch::filter([=](auto const& t){
+            if (not points.empty()) {
+                int i = std::lround(var == "speed" ? common::get<speed>(t) : 10*common::get<crash>(t));
+                return not std::binary_search(points.begin(), points.end(), i);
+            }
             if (var != "none") return false;
             return abs(common::get<speed>(t) - 10*common::get<crash>(t)) > 0.01;
         }),
@@ -40,17 +105,153 @@ auto make_parameters(bool is_sync, int runs, std::string var = "none") {
     );
 }
 
-//! @brief The main function.
-int main() {
-    // Runs the synchronous simulation.
-    batch::run(component::batch_simulator<option::list<true>>{},
-               make_parameters(true, runs*10));
+//! @brief Builds the parameters of a single large asynchronous simulation with the side, seed and density given by the options, without movement nor crashes.
+template <bool files>
+auto make_large(batch_options const& opt) {
+    using namespace option;
+    return batch::make_tagged_tuple_sequence(
+        batch::constant<seed>(opt.large_seed),
+        batch::constant<sync>(false),
+        batch::constant<speed>(0),
+        batch::constant<crash>(0),
+        batch::constant<dens>(opt.large_dens),
+        batch::constant<side>(opt.large),
+        batch::constant<simtype>(0),
+        batch::stringify<log_path>("output/batch-large", "txt"),
+        make_output(std::integral_constant<bool, files>{}),
+        batch::constant<plotter>(&large_p),
+        batch::constant<round_dev>(0.25),
+        batch::formula<dev_num  >([](auto const& t){ return (common::get<dens>(t)*common::get<side>(t)*200)/314; }),
+        batch::formula<end_time >([](auto const& t){ return common::get<side>(t)*15; }),
+        batch::formula<die_time >([](auto const& t){ return common::get<side>(t)*5; })
+    );
+}
+
+//! @brief Builds plots with confidence bands from the cross-seed statistics.
+std::string make_bands(option::stats_t const& s) {
+    std::vector<std::string> ylabels = {"lead", "corr", "spur"};
+    std::stringstream ss;
+    // time plots for the simulations with fixed parameters
+    for (auto const& kv : s.data()) if (kv.first[3] == 0) {
+        std::string path = "-sync" + std::to_string(int(kv.first[0])) + "spe" + std::to_string(int(kv.first[1])) + "crash" + std::to_string(int(kv.first[2]));
+        std::stringstream title;
+        title << "sync = " << kv.first[0] << ", speed = " << kv.first[1] << ", crash = " << kv.first[2];
+        for (size_t i=0; i<option::stats_t::columns; ++i)
+            band_plot(ss, "tim" + std::to_string(i) + path, title.str(), "time", ylabels[i/4], option::stats_names[i], s.series(kv.first, i));
+    }
+    // parameter plots for the sweeps, averaging over times after stabilisation
+    for (int simtype = 1; simtype <= 2; ++simtype) for (int sync = 0; sync <= 1; ++sync) {
+        std::string xlabel = simtype == 1 ? "speed" : "crash";
+        for (size_t i=0; i<option::stats_t::columns; ++i) {
+            std::vector<band_point> v;
+            for (auto const& kv : s.data()) if (kv.first[3] == simtype and kv.first[0] == sync) {
+                band_point b = s.summary(kv.first, i, 100);
+                b.x = kv.first[simtype];
+                v.push_back(b);
+            }
+            if (v.empty()) continue;
+            std::sort(v.begin(), v.end(), [](band_point const& a, band_point const& b){ return a.x < b.x; });
+            band_plot(ss, xlabel + std::to_string(i) + "-sync" + std::to_string(sync), "sync = " + std::to_string(sync), xlabel, ylabels[i/4], option::stats_names[i], v);
+        }
+    }
+    return band_file("batch-bands", ss.str());
+}
+
+//! @brief The runner object, executing a slice of the simulations.
+using runner_t = batch_runner<option::stats_key_t, option::stats_columns_t, option::telemetry_params_t>;
+
+//! @brief Measures the correct and spurious bands of a sweep in a grid point (columns 4 to 11).
+std::vector<band_point> measure_sweep(std::string var, int i) {
+    std::vector<band_point> v;
+    for (auto const& kv : p.stats().data()) {
+        bool found = var == "speed" ? kv.first[3] == 1 and kv.first[1] == i : kv.first[3] == 2 and std::abs(10*kv.first[2] - i) < 1e-6;
+        if (found and kv.first[0] == 0)
+            for (size_t c=4; c<12; ++c)
+                v.push_back(p.stats().summary(kv.first, c, 100));
+    }
+    return v;
+}
+
+//! @brief Runs the speed or crash sweep, refining the grid adaptively where curves bend or are uncertain.
+template <bool files>
+void run_sweep(runner_t& r, std::string var) {
+    // the curves count nodes, so that their scale is the number of devices (with dens = side = 20 in the sweeps)
+    adaptive_sweep s(60, 10, std::vector<double>(8, (20*20*200)/314));
+    while (not s.done()) {
+        std::map<int, std::vector<int>> batches;
+        for (auto const& x : s.next()) batches[x.second].push_back(x.first);
+        for (auto const& b : batches)
+            r.run(option::compiled_batch<false>{},
+                  make_parameters<files>(false, runs, var, b.second, b.first));
+        s.refine([&](int i){ return measure_sweep(var, i); });
+    }
+    std::cerr << var << " sweep: " << s.evaluations() << " evaluations of " << runs << " runs" << std::endl;
+}
+
+//! @brief Runs (the slice of) all the simulations.
+template <bool files>
+void run_all(runner_t& r) {
+    // Runs the synchronous simulation (hosting many seeds in a network, if requested).
+    if (r.options().ensemble > 0)
+        r.run_ensemble<option::dev_num, option::end_time>(option::compiled_batch<true>{}, r.options().ensemble,
+                                                          make_parameters<files>(true, runs*10));
+    else r.run(option::compiled_batch<true>{},
+               make_parameters<files>(true, runs*10));
     // Runs the asynchronous simulation.
-    batch::run(component::batch_simulator<option::list<false>>{},
-               make_parameters(false, runs*10),
-               make_parameters(false, runs, "prob"),
-               make_parameters(false, runs, "speed"));
-    // Builds the resulting plots.
-    std::cout << plot::file("batch", p.build(), {{"MAX_CROP", "1"}, {"LOG_LIN", "10"}});
+    r.run(option::compiled_batch<false>{},
+          make_parameters<files>(false, runs*10));
+    // Runs the asynchronous sweeps (adaptively only on a single shard, since refinement depends on all results).
+    if (adaptive_sweeps and r.options().shards == 1) {
+        run_sweep<files>(r, "prob");
+        run_sweep<files>(r, "speed");
+    } else r.run(option::compiled_batch<false>{},
+                 make_parameters<files>(false, runs, "prob"),
+                 make_parameters<files>(false, runs, "speed"));
+}
+
+//! @brief The main function.
+int main(int argc, char** argv) {
+    runner_t r(parse_options(argc, argv, seed_files, telemetry_file), option::telemetry_names);
+    // Drives devices through a mobility trace, if given.
+    std::unique_ptr<mobility_trace> mobility;
+    if (r.options().mobility.size()) {
+        mobility.reset(new mobility_trace(r.options().mobility));
+        if (not mobility->good()) {
+            std::cerr << "cannot read mobility trace " << r.options().mobility << std::endl;
+            return 1;
+        }
+        // the side of the area of all the runs
+        double side = r.options().large > 0 ? r.options().large : 20;
+        if (not mobility->fits(side)) {
+            std::cerr << "mobility trace " << r.options().mobility << " recorded with side " << mobility->info().side << " instead of " << side << std::endl;
+            return 1;
+        }
+        mobility_trace::active() = mobility.get();
+    }
+    // Rewrites the plots of the results so far, replacing the file at once (in progressive mode).
+    r.on_progress([](){
+        std::string tmp = std::string(partial_plot) + ".tmp";
+        std::ofstream(tmp) << decimate(plot::file("batch", p.build(), {{"MAX_CROP", "1"}, {"LOG_LIN", "10"}}), plot_points);
+        std::rename(tmp.c_str(), partial_plot);
+    });
+    // Runs a single large simulation processed by all threads, if requested.
+    if (r.options().large > 0) {
+        if (r.options().files) r.run(option::compiled_parallel{}, make_large<true>(r.options()));
+        else r.run(option::compiled_parallel{}, make_large<false>(r.options()));
+    } else if (r.options().files) run_all<true>(r);
+    else run_all<false>(r);
+    r.summary(std::cerr);
+    alloc_stats::summary(std::cerr);
+    phase_timers::summary(std::cerr);
+    // Builds the resulting plots (of the large simulation in its own file, leaving the batch plots untouched).
+    if (r.options().large > 0)
+        std::ofstream("plot/batch-large.asy") << decimate(plot::file("batch-large", large_p.build(), {{"MAX_CROP", "1"}, {"LOG_LIN", "10"}}), plot_points);
+    else std::cout << decimate(plot::file("batch", p.build(), {{"MAX_CROP", "1"}, {"LOG_LIN", "10"}}), plot_points);
+    // Builds the plots with confidence bands across seeds (unless only a shard or the large simulation has been run).
+    if (r.options().shards == 1 and r.options().large == 0) std::ofstream("plot/batch-bands.asy") << decimate(make_bands(p.stats()), plot_points);
+    // Builds the histogram of neighbourhood sizes (of the simulations run in this process).
+    std::stringstream hist;
+    neighbour_histogram().plot(hist, "neighbours", "all runs", "neighbours", "rounds");
+    std::ofstream("plot/batch-neighbours.asy") << band_file("batch-neighbours", hist.str(), 1);
     return 0;
 }
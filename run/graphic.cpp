@@ -5,18 +5,29 @@
  * @brief Runs a single execution of the case study comparing election algorithms with a graphical user interface.
  */
 
-#include "lib/simulation_setup.hpp"
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include "lib/decimate.hpp"
+#include "lib/simulation_graphic.hpp"
 
 using namespace fcpp;
 
+//! @brief Maximum number of points in each plot (zero for no decimation).
+constexpr size_t plot_points = 600;
+
 //! @brief The plotter object.
 option::plot_t p;
 
-//! @brief Performs a single graphic run.
+//! @brief The plotter object of the renderer of live simulations (discarded).
+option::plot_t view;
+
+//! @brief Performs a single graphic run (recording a trace if a path is given, and simulating in background if a snapshot period is given).
 template <bool is_sync>
-void graphic_run(bool moving = false) {
-    // The network object type (interactive simulator with given options).
-    using net_t = typename component::interactive_simulator<option::list<is_sync>>::net;
+void graphic_run(bool moving = false, std::string trace = "", double live = 0) {
+    // The network object type (interactive simulator with given options, compiled separately).
+    using net_t = typename option::compiled_graphic<is_sync>::net;
     // The initialisation values (simulation name, texture of the reference plane, node movement speed).
     auto init_v = common::make_tagged_tuple<option::name, option::sync, option::seed, option::speed, option::dens, option::side, option::round_dev, option::dev_num, option::end_time, option::die_time, option::crash, option::plotter, option::area_min, option::area_max>(
         "Leader Election (" + std::string(is_sync ? "" : "a") + "synchronous" + std::string(moving ? ", moving" : "") + ")",
@@ -34,24 +45,138 @@ void graphic_run(bool moving = false) {
         make_vec(0,0),
         make_vec(20,2)
     );
-    // Construct the network object.
+    // The trace recording the run.
+    std::unique_ptr<trace_writer> writer;
+    if (trace.size()) writer.reset(new trace_writer(trace, {uint32_t(common::get<option::dev_num>(init_v)), double(common::get<option::side>(init_v)), double(common::get<option::end_time>(init_v))}));
+    trace_writer::active() = writer.get();
+    if (live > 0) {
+        // Runs the simulation in a background thread, publishing snapshots of nodes every `live` time units (following the clock of the renderer).
+        snapshot_buffer buffer(common::get<option::dev_num>(init_v), live);
+        snapshot_buffer::active() = &buffer;
+        auto batch_v = common::make_tagged_tuple<option::seed, option::sync, option::speed, option::crash, option::dens, option::side, option::simtype, option::output, option::plotter, option::round_dev, option::dev_num, option::end_time, option::die_time>(
+            common::get<option::seed>(init_v),
+            is_sync,
+            common::get<option::speed>(init_v),
+            common::get<option::crash>(init_v),
+            common::get<option::dens>(init_v),
+            common::get<option::side>(init_v),
+            0,
+            &std::cout,
+            &p,
+            common::get<option::round_dev>(init_v),
+            common::get<option::dev_num>(init_v),
+            common::get<option::end_time>(init_v),
+            common::get<option::die_time>(init_v)
+        );
+        std::thread simulation([&](){
+            typename option::compiled_batch<is_sync>::net network{batch_v};
+            network.run();
+            buffer.finish(common::get<option::end_time>(init_v));
+        });
+        // Renders the latest snapshots until exit (with the replay program).
+        common::get<option::plotter>(init_v) = &view;
+        option::compiled_replay::net network{init_v};
+        network.run();
+        buffer.stop();
+        simulation.join();
+        snapshot_buffer::active() = nullptr;
+    } else {
+        // Construct the network object.
+        net_t network{init_v};
+        // Run the simulation until exit.
+        network.run();
+    }
+    trace_writer::active() = nullptr;
+}
+
+//! @brief Replays a recorded trace from a given time, at a given rate (negative to play backwards).
+void replay_run(std::string trace, double start, double rate) {
+    trace_player player(trace);
+    if (not player.good()) {
+        std::cerr << "cannot read trace " << trace << std::endl;
+        return;
+    }
+    player.set_clock(start, rate);
+    trace_player::active() = &player;
+    trace_format::header const& h = player.info();
+    // The network object type (interactive simulator with the replay program, compiled separately).
+    using net_t = option::compiled_replay::net;
+    // The simulated time after which the replay gets out of the trace.
+    double end = rate > 0 ? (h.end_time - start) / rate : start / -rate;
+    auto init_v = common::make_tagged_tuple<option::name, option::sync, option::seed, option::speed, option::dens, option::side, option::round_dev, option::dev_num, option::end_time, option::die_time, option::crash, option::plotter, option::area_min, option::area_max>(
+        "Leader Election (replay of " + trace + ")",
+        true,
+        0,
+        0,
+        20,
+        h.side,
+        0,
+        h.nodes,
+        end,
+        end,
+        0,
+        &p,
+        make_vec(0,0),
+        make_vec(h.side,2)
+    );
     net_t network{init_v};
-    // Run the simulation until exit.
     network.run();
+    trace_player::active() = nullptr;
 }
 
 //! @brief The main function.
-int main() {
+int main(int argc, char** argv) {
+    std::string record, replay, mobility;
+    double start = 0, rate = 1, live = 0;
+    auto usage = [&](){
+        std::cerr << "usage: " << argv[0] << " [--record prefix] [--replay trace [--from t] [--rate r]] [--mobility trace] [--live period]" << std::endl;
+        std::exit(1);
+    };
+    for (int i=1; i<argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--record" and i+1 < argc) record = argv[++i];
+        else if (arg == "--replay" and i+1 < argc) replay = argv[++i];
+        else if (arg == "--from" and i+1 < argc) start = std::stod(argv[++i]);
+        else if (arg == "--rate" and i+1 < argc) rate = std::stod(argv[++i]);
+        else if (arg == "--mobility" and i+1 < argc) mobility = argv[++i];
+        else if (arg == "--live" and i+1 < argc) live = std::stod(argv[++i]);
+        else usage();
+    }
+    if (rate == 0) usage();
     std::cout << "/*\n";
+    if (replay.size()) {
+        // Replays a recorded trace, without simulating.
+        replay_run(replay, start, rate);
+        std::cout << "*/\n";
+        return 0;
+    }
+    // Drives devices through a mobility trace, if given.
+    std::unique_ptr<mobility_trace> driver;
+    if (mobility.size()) {
+        driver.reset(new mobility_trace(mobility));
+        if (not driver->good()) {
+            std::cerr << "cannot read mobility trace " << mobility << std::endl;
+            return 1;
+        }
+        // the side of the area of all the runs
+        if (not driver->fits(20)) {
+            std::cerr << "mobility trace " << mobility << " recorded with side " << driver->info().side << " instead of 20" << std::endl;
+            return 1;
+        }
+        mobility_trace::active() = driver.get();
+    }
+    auto trace = [&](std::string name) {
+        return record.size() ? record + "-" + name + ".trace" : "";
+    };
     // Runs the synchronous simulation.
-    graphic_run<true>();
+    graphic_run<true>(false, trace("sync"), live);
     // Runs the asynchronous simulation.
-    graphic_run<false>();
+    graphic_run<false>(false, trace("async"), live);
     // Runs the synchronous moving simulation.
-    graphic_run<true>(true);
+    graphic_run<true>(true, trace("sync-moving"), live);
     // Runs the asynchronous moving simulation.
-    graphic_run<false>(true);
+    graphic_run<false>(true, trace("async-moving"), live);
     // Builds the resulting plots.
-    std::cout << "*/\n" << plot::file("graphic", p.build(), {{"MAX_CROP", "1"}, {"LOG_LIN", "10"}});
+    std::cout << "*/\n" << decimate(plot::file("graphic", p.build(), {{"MAX_CROP", "1"}, {"LOG_LIN", "10"}}), plot_points);
     return 0;
 }
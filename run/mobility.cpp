@@ -0,0 +1,66 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file mobility.cpp
+ * @brief Generates mobility traces of devices moving by random waypoints, for driving the simulations through `--mobility`.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mobility_trace.hpp"
+
+using namespace fcpp;
+
+//! @brief The main function.
+int main(int argc, char** argv) {
+    std::string path;
+    // defaults matching the graphic simulations (254 devices in a 20x2 area for 300 time units)
+    uint32_t devices = 254;
+    double side = 20, end = 300, step = 0.5, speed = 0.3;
+    unsigned seed = 0;
+    auto usage = [&](){
+        std::cerr << "usage: " << argv[0] << " <file> [--devices n] [--side s] [--end t] [--step dt] [--speed v] [--seed k]" << std::endl;
+        std::exit(1);
+    };
+    for (int i=1; i<argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--devices" and i+1 < argc) devices = std::stoul(argv[++i]);
+        else if (arg == "--side" and i+1 < argc) side = std::stod(argv[++i]);
+        else if (arg == "--end" and i+1 < argc) end = std::stod(argv[++i]);
+        else if (arg == "--step" and i+1 < argc) step = std::stod(argv[++i]);
+        else if (arg == "--speed" and i+1 < argc) speed = std::stod(argv[++i]);
+        else if (arg == "--seed" and i+1 < argc) seed = std::stoul(argv[++i]);
+        else if (path.empty() and arg.size() and arg[0] != '-') path = arg;
+        else usage();
+    }
+    if (path.empty() or devices == 0 or side <= 0 or end < 0 or step <= 0 or speed < 0) usage();
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> rx(0, side), ry(0, 2);
+    // every device moves towards a random waypoint, picking a new one once reached
+    std::vector<mobility_format::position_type> pos(devices), way(devices);
+    for (uint32_t d=0; d<devices; ++d) {
+        pos[d] = {{float(rx(gen)), float(ry(gen))}};
+        way[d] = {{float(rx(gen)), float(ry(gen))}};
+    }
+    mobility_writer w(path, devices, 0, step, side);
+    for (double t = 0; t <= end + step/2; t += step) {
+        w.sample(pos);
+        for (uint32_t d=0; d<devices; ++d) {
+            double dx = way[d][0] - pos[d][0], dy = way[d][1] - pos[d][1];
+            double dist = std::sqrt(dx*dx + dy*dy);
+            if (dist <= speed * step) {
+                pos[d] = way[d];
+                way[d] = {{float(rx(gen)), float(ry(gen))}};
+            } else {
+                pos[d][0] += dx / dist * speed * step;
+                pos[d][1] += dy / dist * speed * step;
+            }
+        }
+    }
+    return 0;
+}
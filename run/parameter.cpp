@@ -1,16 +1,31 @@
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <string>
 
 #include "lib/func.hpp"
+#include "lib/decimate.hpp"
 #include "lib/common/plot.hpp"
 
-// double checks that the constraints are satisfied
-frac double_check(const func& g, int L) {
-    frac K = 1;
-    for (int x=0; x<L; ++x)
-        K = std::max(K, frac(g.recovery(x), g.ideal(x)));
-    return K;
+// maximum number of points in each plot (zero for no decimation)
+constexpr size_t plot_points = 1000;
+
+// header where the simpler function is exported as a compile-time table, given as argument or found from this source file
+// (the best function is not, since it has hundreds of thousands of breakpoints)
+std::string table_header(int argc, char** argv) {
+    if (argc > 1) return argv[1];
+    std::string source = __FILE__;
+    size_t slash = source.find_last_of("/\\");
+    return (slash == std::string::npos ? std::string(".") : source.substr(0, slash)) + "/../lib/g_function.hpp";
+}
+
+// triple checks that the constraints are satisfied for all x
+void triple_check(const func& g) {
+    certificate c = g.certify();
+    std::cout << "TRIPLE CHECK: " << c.found << " = " << double(c.found) << ", checked up to " << c.threshold;
+    if (c.valid) std::cout << ", proven for all x" << std::endl;
+    else std::cout << ", FAILED to prove " << c.bound << " for all x" << std::endl;
 }
 
 // searches for the best competitiveness within [a,b]
@@ -55,13 +70,12 @@ std::string to_graph(func const& g) {
         p << common::make_tagged_tuple<x, aggregator::mean<y<best>, true>, aggregator::mean<y<asymptotic>, true>>(i, g.dir(i), offs + (1 + sqrt(2))*i);
     }
     std::stringstream ss;
-    ss << plot::file("parameter", p.build(), {{"styles[1]", "dotted"}, {"colors[1]", "heavyred"}});
+    ss << fcpp::decimate(plot::file("parameter", p.build(), {{"styles[1]", "dotted"}, {"colors[1]", "heavyred"}}), plot_points);
     return ss.str();
 }
 
-int main() {
+int main(int argc, char** argv) {
     std::string plot;
-    int L = 10000000;
     std::cout.precision(17);
     std::cout << "/*\n";
     {
@@ -75,8 +89,7 @@ int main() {
         func g(U);
         K = g.competitiveness();
         std::cout << "DOUBLE CHECK: " << K << " = " << double(K) << ", " << g.size() << " custom values, " << g.offset() << " offset" << std::endl;
-        K = double_check(g, L);
-        std::cout << "TRIPLE CHECK: " << K << " = " << double(K) << ", checked up to " << L << std::endl;
+        triple_check(g);
         std::cout << g << std::endl << std::endl;
         plot = to_graph(g);
     }
@@ -86,9 +99,12 @@ int main() {
         func g(K);
         K = g.competitiveness();
         std::cout << "DOUBLE CHECK: " << K << " = " << double(K) << ", " << g.size() << " custom values, " << g.offset() << " offset" << std::endl;
-        K = double_check(g, L);
-        std::cout << "TRIPLE CHECK: " << K << " = " << double(K) << ", checked up to " << L << std::endl;
+        triple_check(g);
         std::cout << g << std::endl << std::endl;
+        std::string path = table_header(argc, argv);
+        std::ofstream header(path);
+        print_header(header, g);
+        std::cout << "EXPORTED TO " << path << std::endl;
     }
     std::cout << "*/\n" << plot;
 }
@@ -0,0 +1,163 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file recovery.cpp
+ * @brief Measures the convergence and recovery latency of the election algorithms, comparing them with the bounds predicted by the guiding function.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include "lib/func.hpp"
+#include "lib/simulation_setup.hpp"
+
+using namespace fcpp;
+
+//! @brief Number of runs (seeds) for every side of the area.
+constexpr int runs = 20;
+
+//! @brief Names of the algorithms monitored (in the order of `recovery_monitor`).
+const std::vector<std::string> algorithm_names = {"GCF", "Datta", "GCF__filtered", "Datta__filtered"};
+
+//! @brief Stream buffer discarding everything written into it.
+struct discard_buffer : public std::streambuf {
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(char const*, std::streamsize n) override {
+        return n;
+    }
+};
+
+//! @brief Stream discarding the logs of single runs.
+discard_buffer discard_buf;
+std::ostream discard(&discard_buf);
+
+//! @brief The plotter object (unused, but required by the simulator).
+option::plot_t p;
+
+//! @brief Builds a sequence of parameters sweeping the side of the area, without movement nor crashes.
+template <bool is_sync>
+auto make_parameters() {
+    using namespace option;
+    return batch::make_tagged_tuple_sequence(
+        batch::arithmetic<seed>(0, runs-1, 1),
+        batch::constant<sync>(is_sync),
+        batch::constant<speed>(0),
+        batch::constant<crash>(0),
+        batch::constant<dens>(10),
+        batch::arithmetic<side>(5, 40, 5),
+        batch::constant<simtype>(-1),
+        batch::constant<output>(&discard),
+        batch::constant<plotter>(&p),
+        batch::formula<round_dev>([](auto const& t){ return is_sync ? 0 : 0.25; }),
+        batch::formula<dev_num  >([](auto const& t){ return (common::get<dens>(t)*common::get<side>(t)*200)/314; }),
+        batch::formula<end_time >([](auto const& t){ return common::get<side>(t)*15; }),
+        batch::formula<die_time >([](auto const& t){ return common::get<side>(t)*5; })
+    );
+}
+
+//! @brief Latencies measured in a run.
+struct run_latency {
+    //! @brief the side of the area
+    int side;
+    //! @brief the seed of the run
+    int seed;
+    //! @brief convergence and recovery latency of every algorithm
+    std::array<double, recovery_monitor::algorithms> convergence, recovery;
+};
+
+//! @brief Runs all the simulations in parallel, monitoring their latencies.
+template <bool is_sync>
+std::vector<run_latency> run_all() {
+    auto v = make_parameters<is_sync>();
+    std::vector<run_latency> r(v.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    for (unsigned k=0; k<std::max(1u, std::thread::hardware_concurrency()); ++k)
+        pool.emplace_back([&](){
+            for (size_t i; (i = next++) < v.size(); ) {
+                auto t = v[i];
+                // the monitor of the run, fed by the nodes in this thread
+                recovery_monitor m(common::get<option::die_time>(t), common::get<option::end_time>(t));
+                recovery_monitor::active() = &m;
+                {
+                    typename option::compiled_batch<is_sync>::net network{t};
+                    network.run();
+                }
+                recovery_monitor::active() = nullptr;
+                r[i].side = common::get<option::side>(t);
+                r[i].seed = common::get<option::seed>(t);
+                for (size_t a=0; a<recovery_monitor::algorithms; ++a) {
+                    r[i].convergence[a] = m.convergence(a);
+                    r[i].recovery[a] = m.recovery(a);
+                }
+            }
+        });
+    for (std::thread& t : pool) t.join();
+    return r;
+}
+
+//! @brief Plots the worst latency measured for every side against a predicted bound (x being the side, the hop diameter of the area).
+std::string make_plot(std::vector<run_latency> const& r, bool recovery, func const& g, std::string const& title) {
+    std::map<int, std::array<double, recovery_monitor::algorithms>> worst;
+    std::map<int, std::array<int, recovery_monitor::algorithms>> failures;
+    for (run_latency const& l : r) {
+        worst[l.side];
+        failures[l.side];
+        for (size_t a=0; a<recovery_monitor::algorithms; ++a) {
+            double x = recovery ? l.recovery[a] : l.convergence[a];
+            if (std::isinf(x)) ++failures[l.side][a];
+            else worst[l.side][a] = std::max(worst[l.side][a], x);
+        }
+    }
+    std::vector<std::string> names;
+    for (std::string const& n : algorithm_names) names.push_back(n + " (max)");
+    names.push_back(recovery ? "recovery(x)" : "convergence(x)");
+    names.push_back("ideal(x)");
+    std::vector<std::vector<std::pair<double, double>>> v(names.size());
+    for (auto const& kv : worst) {
+        for (size_t a=0; a<recovery_monitor::algorithms; ++a)
+            if (failures[kv.first][a] == 0) v[a].emplace_back(kv.first, kv.second[a]);
+            else std::cout << algorithm_names[a] << " did not " << (recovery ? "recover" : "converge") << " in " << failures[kv.first][a] << " runs with side " << kv.first << " (" << title << ")" << std::endl;
+        v[recovery_monitor::algorithms].emplace_back(kv.first, recovery ? g.recovery(kv.first) : g.convergence(kv.first));
+        v[recovery_monitor::algorithms+1].emplace_back(kv.first, g.ideal(kv.first));
+    }
+    std::stringstream ss;
+    series_plot(ss, std::string(recovery ? "rec" : "conv") + "-" + title, title, "side", recovery ? "recovery" : "convergence", names, v);
+    return ss.str();
+}
+
+//! @brief Prints the latencies of every run.
+void print_runs(std::vector<run_latency> const& r, std::string const& title) {
+    std::cout << title << ": side seed";
+    for (std::string const& n : algorithm_names) std::cout << " conv(" << n << ")";
+    for (std::string const& n : algorithm_names) std::cout << " rec(" << n << ")";
+    std::cout << std::endl;
+    for (run_latency const& l : r) {
+        std::cout << l.side << " " << l.seed;
+        for (double x : l.convergence) std::cout << " " << x;
+        for (double x : l.recovery) std::cout << " " << x;
+        std::cout << std::endl;
+    }
+}
+
+//! @brief The main function.
+int main() {
+    // The guiding function of the GCF algorithm (see lib/g_function.hpp).
+    func g(frac(5,2));
+    std::cout << "/*\n";
+    std::vector<run_latency> rs = run_all<true>();
+    std::vector<run_latency> ra = run_all<false>();
+    print_runs(rs, "sync");
+    print_runs(ra, "async");
+    std::string plots = make_plot(rs, true, g, "sync") + make_plot(ra, true, g, "async") + make_plot(rs, false, g, "sync") + make_plot(ra, false, g, "async");
+    std::cout << "*/\n" << band_file("recovery", plots, 4);
+    return 0;
+}
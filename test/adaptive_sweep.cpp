@@ -0,0 +1,60 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file adaptive_sweep.cpp
+ * @brief Checks the refinements of adaptive sweeps on synthetic curves.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <map>
+
+#include "lib/adaptive_sweep.hpp"
+#include "lib/philox.hpp"
+
+using namespace fcpp;
+
+//! @brief Normal noise with a given deviation, keyed by a point and its number of seed batches (so that it is the same on every platform).
+double noise(double dev, int i, int batches) {
+    double u = counter_real(42, i, batches, 0), v = counter_real(42, i, batches, 1);
+    return dev * std::sqrt(-2 * std::log(1 - u)) * std::cos(2 * std::acos(-1.0) * v);
+}
+
+//! @brief Runs a sweep of a curve (given the point and the number of seed batches) to completion, returning the number of point evaluations.
+template <typename F>
+size_t sweep(F&& curve, double scale) {
+    adaptive_sweep s(60, 10, {scale});
+    std::map<int, int> batches;
+    while (not s.done()) {
+        for (auto const& x : s.next()) batches[x.first] = x.second + 1;
+        s.refine([&](int i){
+            return std::vector<band_point>{curve(i, batches[i])};
+        });
+    }
+    return s.evaluations();
+}
+
+//! @brief The main function.
+int main() {
+    int failures = 0;
+    // a flat curve with some noise (as the spurious counts, about zero), on the scale of 254 devices
+    size_t flat = sweep([](int i, int batches){
+        double m = noise(0.3, i, batches);
+        double e = 0.5 / std::sqrt(batches);
+        return band_point{0, m, m - e, m + e, m - 2*e, m + 2*e};
+    }, 254);
+    if (flat != 7) {
+        std::cerr << "flat noisy curve refined: " << flat << " evaluations instead of 7" << std::endl;
+        ++failures;
+    }
+    // a curve with a step (as the correct counts dropping with crashes), refined around the step
+    size_t step = sweep([](int i, int){
+        double m = i < 25 ? 254 : 50;
+        return band_point{0, m, m - 1, m + 1, m - 2, m + 2};
+    }, 254);
+    if (step <= 7) {
+        std::cerr << "step curve not refined: " << step << " evaluations" << std::endl;
+        ++failures;
+    }
+    return failures;
+}
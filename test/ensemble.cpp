@@ -0,0 +1,69 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file ensemble.cpp
+ * @brief Checks that the replicas of an ensemble are sampled separately, as separate runs.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "lib/ensemble.hpp"
+
+using namespace fcpp;
+
+//! @brief Checks a row of a replica (time, distinct leaders, correct and spurious nodes of the first algorithm).
+int check(ensemble_monitor const& m, size_t r, size_t i, std::vector<double> expected) {
+    std::vector<double> const& row = m.rows(r)[i];
+    std::vector<double> found = {row[0], row[1], row[1 + ensemble_monitor::algorithms], row[1 + 2 * ensemble_monitor::algorithms]};
+    if (found == expected) return 0;
+    std::cerr << "replica " << r << " row " << i << ":";
+    for (double x : found) std::cerr << " " << x;
+    std::cerr << " instead of";
+    for (double x : expected) std::cerr << " " << x;
+    std::cerr << std::endl;
+    return 1;
+}
+
+//! @brief The main function.
+int main() {
+    int failures = 0;
+    // two replicas of three devices, sampled at times 0 to 3
+    ensemble_monitor m({7, 8}, 3, 3);
+    if (m.replicas() != 2 or m.seed(1) != 8) {
+        std::cerr << "wrong replicas or seeds" << std::endl;
+        ++failures;
+    }
+    // replica 0 agrees on leader 0 at time 1, then device 0 leaves and the others elect 1 at time 2
+    for (device_t d = 0; d < 3; ++d) m.record(0, 1, d, {{0, 0, 0, 0}}, false, true);
+    m.record(0, 2, 0, {{0, 0, 0, 0}}, true, false);
+    for (device_t d = 1; d < 3; ++d) m.record(0, 2, d, {{1, 1, 1, 1}}, true, true);
+    // replica 1 disagrees at time 1 (a spurious leader 2), and agrees from time 2
+    for (device_t d = 0; d < 3; ++d) m.record(1, 1, d, {{d == 2 ? 2u : 0u, 0, 0, 0}}, false, true);
+    for (device_t d = 0; d < 3; ++d) m.record(1, 2, d, {{0, 0, 0, 0}}, false, true);
+    m.finish();
+    for (size_t r = 0; r < 2; ++r)
+        if (m.rows(r).size() != 4) {
+            std::cerr << "replica " << r << " has " << m.rows(r).size() << " rows instead of 4" << std::endl;
+            return 1;
+        }
+    // rows are sampled before the rounds at their time, starting from the defaults of the node storage
+    failures += check(m, 0, 0, {0, 1, 0, 0});
+    failures += check(m, 0, 1, {1, 1, 0, 0});
+    failures += check(m, 0, 2, {2, 1, 3, 0});
+    failures += check(m, 0, 3, {3, 1, 2, 0});
+    failures += check(m, 1, 1, {1, 1, 0, 0});
+    failures += check(m, 1, 2, {2, 2, 2, 1});
+    failures += check(m, 1, 3, {3, 1, 3, 0});
+    // the first rows of a replica are those of a separate run, whose nodes have not run a round yet
+    failures += check(m, 1, 0, {0, 1, 0, 0});
+    ensemble_monitor single({8}, 3, 3);
+    for (device_t d = 0; d < 3; ++d) single.record(0, 1, d, {{d == 2 ? 2u : 0u, 0, 0, 0}}, false, true);
+    for (device_t d = 0; d < 3; ++d) single.record(0, 2, d, {{0, 0, 0, 0}}, false, true);
+    single.finish();
+    if (single.rows(0) != m.rows(1)) {
+        std::cerr << "replica 1 differs from a separate run with the same seed" << std::endl;
+        ++failures;
+    }
+    return failures;
+}
@@ -0,0 +1,62 @@
+// Copyright © 2022 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file live_snapshot.cpp
+ * @brief Checks headlessly that live simulations follow the clock of the renderer.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "lib/live_snapshot.hpp"
+
+using namespace fcpp;
+
+//! @brief The main function.
+int main() {
+    int failures = 0;
+    constexpr uint32_t nodes = 254;
+    constexpr double period = 1, end = 300;
+    snapshot_buffer buffer(nodes, period);
+    // a simulation recording every node at every half time unit, as fast as it is allowed to
+    std::atomic<double> simulated{0};
+    std::thread simulation([&](){
+        for (double t = 0; t <= end; t += 0.5) {
+            for (uint32_t uid = 0; uid < nodes; ++uid) buffer.record(t, uid, trace_state{});
+            simulated = t;
+        }
+        buffer.finish(end);
+        simulated = end + 1;
+    });
+    // a renderer advancing its clock, which may be ahead of the simulation by the lead and a period at most
+    double ahead = 0;
+    auto render = [&](double t) {
+        buffer.state(0, t);
+        ahead = std::max(ahead, simulated - t);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        ahead = std::max(ahead, simulated - t);
+    };
+    for (double t = 0; t <= 100; t += 0.5) render(t);
+    // the renderer pauses, and so does the simulation
+    double paused = simulated;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (simulated != paused) {
+        std::cerr << "simulation advanced from " << paused << " to " << simulated << " while paused" << std::endl;
+        ++failures;
+    }
+    for (double t = 100; t <= 150; t += 0.5) render(t);
+    if (ahead > 3 * period) {
+        std::cerr << "simulation ahead of the renderer by " << ahead << " time units" << std::endl;
+        ++failures;
+    }
+    // the renderer exits before the end, and the simulation completes unthrottled
+    buffer.stop();
+    simulation.join();
+    if (simulated != end + 1) {
+        std::cerr << "simulation stopped at " << simulated << std::endl;
+        ++failures;
+    }
+    return failures;
+}